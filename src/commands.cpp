@@ -0,0 +1,160 @@
+#include <commands.h>
+
+static const char *SkipSpaces(const char *p) {
+  while (*p == ' ' || *p == '\t') {
+    p++;
+  }
+  return p;
+}
+
+// Read an optionally signed decimal integer at p into 'value'. Returns
+// the character after it, or NULL if there isn't one or it doesn't fit.
+static const char *ParseInt32(const char *p, int32_t &value) {
+  bool negative = false;
+  if (*p == '-' || *p == '+') {
+    negative = (*p == '-');
+    p++;
+  }
+  if (*p < '0' || *p > '9') {
+    return NULL;
+  }
+  const uint32_t limit = negative ? 2147483648u : 2147483647u;
+  uint32_t magnitude = 0;
+  do {
+    uint32_t digit = *p++ - '0';
+    if (magnitude > (limit - digit) / 10) {
+      return NULL;
+    }
+    magnitude = magnitude * 10 + digit;
+  } while (*p >= '0' && *p <= '9');
+  value = negative ? (int32_t)(0u - magnitude) : (int32_t)magnitude;
+  return p;
+}
+
+bool ParseCommandArgs(const char *text, CommandArgs &args) {
+  args.hasKey = false;
+  args.key = 0;
+  args.count = 0;
+  if (text == NULL) {
+    return false;
+  }
+
+  const char *p = SkipSpaces(text);
+  if (*p == '\0') {
+    return true;
+  }
+  for (;;) {
+    int32_t value;
+    p = ParseInt32(p, value);
+    if (p == NULL) {
+      return false;
+    }
+    p = SkipSpaces(p);
+    if (*p == '=') {
+      // only the first integer can be a key
+      if (args.hasKey || args.count) {
+        return false;
+      }
+      args.hasKey = true;
+      args.key = value;
+      p = SkipSpaces(p + 1);
+      continue;
+    }
+    if (args.count == COMMAND_MAX_VALUES) {
+      return false;
+    }
+    args.values[args.count++] = value;
+    if (*p == '\0') {
+      return true;
+    }
+    if (*p != ',') {
+      return false;
+    }
+    p = SkipSpaces(p + 1);
+  }
+}
+
+#ifdef COMMANDS_FUZZ
+// TEST / VERIFICATION CODE ONLY BELOW THIS POINT
+// Host fuzz test of ParseCommandArgs against a strtoll-based reference.
+// From this directory:
+//   g++ -I. -DCOMMANDS_FUZZ commands.cpp && ./a.out
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool ReferenceParse(const char *text, CommandArgs &args) {
+  args.hasKey = false;
+  args.count = 0;
+  const char *p = text;
+  while (*p == ' ' || *p == '\t') p++;
+  if (*p == '\0') return true;
+  for (;;) {
+    if (!(isdigit((unsigned char)*p) ||
+          ((*p == '-' || *p == '+') && isdigit((unsigned char)p[1])))) {
+      return false;
+    }
+    char *end;
+    errno = 0;
+    long long v = strtoll(p, &end, 10);
+    if (errno || v < -2147483648LL || v > 2147483647LL) return false;
+    p = end;
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '=') {
+      if (args.hasKey || args.count) return false;
+      args.hasKey = true;
+      args.key = v;
+      p++;
+      while (*p == ' ' || *p == '\t') p++;
+      continue;
+    }
+    if (args.count == COMMAND_MAX_VALUES) return false;
+    args.values[args.count++] = v;
+    if (*p == '\0') return true;
+    if (*p != ',') return false;
+    p++;
+    while (*p == ' ' || *p == '\t') p++;
+  }
+}
+
+int main() {
+  static const char kAlphabet[] = "0123456789=,-+ \tx.";
+  static const char *kSeeds[] = {"",        "50",          "0=1",
+                                 " 1 , 2 ", "2147483647",  "-2147483648",
+                                 "2147483648", "1=2=3",    "1,2,3,4,5,6,7,8,9",
+                                 "=1",      "1,",          "- 1"};
+  char text[64];
+  unsigned long bad = 0, accepted = 0, runs = 0;
+  srand(1);
+  for (unsigned long i = 0; i < 20000000; i++) {
+    if (i < sizeof(kSeeds) / sizeof(kSeeds[0])) {
+      strcpy(text, kSeeds[i]);
+    } else {
+      int n = rand() % 24;
+      for (int k = 0; k < n; k++) {
+        text[k] = (rand() % 8) ? kAlphabet[rand() % (sizeof(kAlphabet) - 1)]
+                               : (char)(1 + rand() % 255);
+      }
+      text[n] = '\0';
+    }
+    CommandArgs a, b;
+    bool ok = ParseCommandArgs(text, a);
+    bool ref = ReferenceParse(text, b);
+    runs++;
+    if (ok != ref) {
+      bad++;
+    } else if (ok) {
+      accepted++;
+      if (a.hasKey != b.hasKey || (a.hasKey && a.key != b.key) ||
+          a.count != b.count ||
+          memcmp(a.values, b.values, a.count * sizeof(int32_t))) {
+        bad++;
+      }
+    }
+  }
+  printf("%lu inputs, %lu accepted, %lu disagreements\n", runs, accepted, bad);
+  return bad != 0;
+}
+#endif
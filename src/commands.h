@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// What the cloud asks the lights to do. The Particle function handlers
+// only turn their arguments into a Command and push it onto gCommands;
+// loop() pops and applies them between frames, so nothing a handler
+// does can land in the middle of drawing or showing a frame.
+enum CommandOp : uint8_t {
+  kCommandLightsOn,
+  kCommandLightsOff,
+  kCommandSetBrightness,  // value: 0..MAX_BRIGHTNESS
+  kCommandNotify,
+  kCommandNextPattern,
+  kCommandMerryXmas,
+  kCommandScene,
+  kCommandTwinkle,
+};
+
+// The twinkle engine's settings; the defines of the same names in
+// main.cpp are the defaults.
+struct TwinkleParams {
+  uint8_t speed;                 // 0..8, TWINKLE_SPEED
+  uint8_t density;               // 0..8, TWINKLE_DENSITY
+  uint16_t secondsPerPalette;    // 1..3600, SECONDS_PER_PALETTE
+  uint8_t coolLikeIncandescent;  // 0 or 1, COOL_LIKE_INCANDESCENT
+};
+
+// A whole look at once, from the "scene" cloud function. loop() applies
+// every part of it together, between two frames.
+struct Scene {
+  bool on;
+  uint8_t brightness;      // 0..MAX_BRIGHTNESS
+  uint8_t palette;         // index into ActivePaletteList
+  uint8_t twinkleSpeed;    // 0..8, as TWINKLE_SPEED
+  uint8_t twinkleDensity;  // 0..8, as TWINKLE_DENSITY
+  uint16_t transitionMs;   // how long to fade palette and brightness over
+};
+
+struct Command {
+  CommandOp op;
+  union {
+    int32_t value;
+    Scene scene;
+    TwinkleParams twinkle;
+  };
+};
+
+// The most values one cloud function argument can carry.
+#define COMMAND_MAX_VALUES 8
+
+// A cloud function's argument, read straight out of the string the
+// cloud sent: an optional integer key followed by '=', then up to
+// COMMAND_MAX_VALUES integers separated by ','. Spaces and tabs around
+// any of them are allowed, and so is an empty argument (no key, no
+// values). "50", "0=1" and "1, 200, -3" are all fine.
+struct CommandArgs {
+  bool hasKey;
+  int32_t key;
+  uint8_t count;
+  int32_t values[COMMAND_MAX_VALUES];
+};
+
+// Parse 'text' into 'args', without copying it or allocating. False if
+// it isn't in the form above (including any integer outside int32_t);
+// 'args' then holds whatever was read before the problem.
+bool ParseCommandArgs(const char *text, CommandArgs &args);
+
+// A fixed-size ring of Commands for exactly one producer (the cloud
+// handlers) and one consumer (loop()). Neither side blocks or
+// allocates: push() fails when the ring is full and pop() when it is
+// empty. SIZE must be a power of two no larger than 128; the ring holds
+// SIZE - 1 commands.
+template <uint8_t SIZE>
+class CommandQueue {
+  static_assert(SIZE >= 2 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0,
+                "CommandQueue SIZE must be a power of two, 2..128");
+
+ public:
+  CommandQueue() : head_(0), tail_(0) {}
+
+  // Producer side. False if the ring is full; the command is dropped.
+  bool push(const Command &command) {
+    uint8_t head = head_.load(std::memory_order_relaxed);
+    uint8_t next = (head + 1) & (SIZE - 1);
+    if (next == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    ring_[head] = command;
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. False if there is nothing to pop.
+  bool pop(Command &command) {
+    uint8_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    command = ring_[tail];
+    tail_.store((tail + 1) & (SIZE - 1), std::memory_order_release);
+    return true;
+  }
+
+ private:
+  Command ring_[SIZE];
+  std::atomic<uint8_t> head_;  // next slot push() writes; producer only
+  std::atomic<uint8_t> tail_;  // next slot pop() reads; consumer only
+};
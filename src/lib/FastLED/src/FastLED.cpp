@@ -41,10 +41,14 @@ CLEDController &CFastLED::addLeds(CLEDController *pLed,
 	return *pLed;
 }
 
-void CFastLED::show(uint8_t scale) {
+void CFastLED::waitToShow() {
 	// guard against showing too rapidly
 	while(m_nMinMicros && ((micros()-lastshow) < m_nMinMicros));
 	lastshow = micros();
+}
+
+void CFastLED::show(uint8_t scale) {
+	waitToShow();
 
 	CLEDController *pCur = CLEDController::head();
 	while(pCur) {
@@ -57,6 +61,22 @@ void CFastLED::show(uint8_t scale) {
 	countFPS();
 }
 
+void CFastLED::show(const uint8_t *scales, uint8_t nScales) {
+	waitToShow();
+
+	uint8_t x = 0;
+	CLEDController *pCur = CLEDController::head();
+	while(pCur) {
+		uint8_t d = pCur->getDither();
+		if(m_nFPS < 100) { pCur->setDither(0); }
+		pCur->showLeds((x < nScales) ? scales[x] : m_Scale);
+		pCur->setDither(d);
+		pCur = pCur->next();
+		x++;
+	}
+	countFPS();
+}
+
 int CFastLED::count() {
     int x = 0;
 	CLEDController *pCur = CLEDController::head();
@@ -80,8 +100,7 @@ CLEDController & CFastLED::operator[](int x) {
 }
 
 void CFastLED::showColor(const struct CRGB & color, uint8_t scale) {
-	while(m_nMinMicros && ((micros()-lastshow) < m_nMinMicros));
-	lastshow = micros();
+	waitToShow();
 
 	CLEDController *pCur = CLEDController::head();
 	while(pCur) {
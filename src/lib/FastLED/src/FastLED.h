@@ -47,6 +47,7 @@
 #include "colorpalettes.h"
 
 #include "noise.h"
+#include "ledlayout.h"
 #include "power_mgt.h"
 
 #include "fastspi.h"
@@ -385,6 +386,12 @@ public:
 	/// Update all our controllers with the current led colors
 	void show() { show(m_Scale); }
 
+	/// Update all our controllers with the current led colors, each one at
+	/// its own brightness
+	/// @param scales the brightness for each controller, in the same order as FastLED[]
+	/// @param nScales how many entries scales has; any controllers past that use the global brightness
+	void show(const uint8_t *scales, uint8_t nScales);
+
 	void clear(boolean writeData = false);
 
 	void clearData();
@@ -424,6 +431,11 @@ public:
 	/// @param refresh - maximum refresh rate in hz
 	void setMaxRefreshRate(uint16_t refresh);
 
+	/// Wait until the maximum refresh rate allows another frame out, and mark
+	/// the frame as started.  show() does this itself; it's for code that shows
+	/// controllers directly, like CControllerSet.
+	void waitToShow();
+
 	/// for debugging, will keep track of time between calls to countFPS, and every
 	/// nFrames calls, it will update an internal counter for the current FPS.
 	/// @todo make this a rolling counter
@@ -0,0 +1 @@
+#include "../bench8.h"
\ No newline at end of file
@@ -0,0 +1 @@
+#include "../ledlayout.h"
\ No newline at end of file
@@ -0,0 +1 @@
+#include "../postprocess.h"
\ No newline at end of file
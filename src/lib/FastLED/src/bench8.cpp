@@ -0,0 +1,167 @@
+#define FASTLED_INTERNAL
+#include <stdio.h>
+#include "FastLED.h"
+#include "bench8.h"
+
+#if !defined(__arm__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#endif
+
+FASTLED_NAMESPACE_BEGIN
+
+void bench8_init()
+{
+#if defined(__arm__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+uint32_t bench8_cycles()
+{
+#if defined(__arm__)
+    return DWT->CYCCNT;
+#elif defined(__i386__) || defined(__x86_64__)
+    return (uint32_t)__rdtsc();
+#else
+    return micros();
+#endif
+}
+
+const char * bench8_units()
+{
+#if defined(__arm__)
+    return "cycles";
+#elif defined(__i386__) || defined(__x86_64__)
+    return "TSC ticks";
+#else
+    return "us";
+#endif
+}
+
+// Inputs are read from tables so the compiler can't fold the calls,
+// and each result is forced through a register so that the loop can't
+// be vectorised or dropped.
+#define BENCH8_KEEP(x) asm volatile( "" : "+r" (x))
+
+static uint8_t  in8[256];
+static uint16_t in16[256];
+static volatile uint32_t sink;
+
+// Best-of-BENCH8_RUNS total cycles for BENCH8_ITERATIONS of EXPR.
+// Inside EXPR, a and b are varying uint8_t inputs, w is a varying
+// uint16_t input, and n is the iteration number.
+#define BENCH8_TIME(RESULT, EXPR)                                       \
+    do {                                                                \
+        RESULT = 0xFFFFFFFF;                                            \
+        for( uint8_t run = 0; run < BENCH8_RUNS; run++) {               \
+            uint32_t acc = 0;                                           \
+            uint32_t t0 = bench8_cycles();                              \
+            for( uint16_t n = 0; n < BENCH8_ITERATIONS; n++) {          \
+                uint8_t  a = in8[ n & 0xFF ];                           \
+                uint8_t  b = in8[ (n + 85) & 0xFF ];                    \
+                uint16_t w = in16[ n & 0xFF ];                          \
+                (void)a; (void)b; (void)w;                              \
+                acc += (EXPR);                                          \
+                BENCH8_KEEP( acc);                                      \
+            }                                                           \
+            uint32_t t = bench8_cycles() - t0;                          \
+            sink = acc;                                                 \
+            if( t < RESULT) RESULT = t;                                 \
+        }                                                               \
+    } while(0)
+
+static void bench8_tenths( char * out, uint32_t total)
+{
+    uint32_t tenths = (total * 10 + BENCH8_ITERATIONS / 2) / BENCH8_ITERATIONS;
+    snprintf( out, 12, "%lu.%01lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+}
+
+// Print one row: name, then the cost per call both including and
+// excluding the bare loop, in tenths of a unit.
+static void bench8_row( bench8_print_fn print, const char * name,
+                        uint32_t total, uint32_t overhead)
+{
+    char gross[12], net[12], line[64];
+    bench8_tenths( gross, total);
+    bench8_tenths( net, total > overhead ? total - overhead : 0);
+    snprintf( line, sizeof(line), "%-22s %8s %8s\r\n", name, gross, net);
+    print( line);
+}
+
+#define BENCH8_ROW(NAME, EXPR)                                          \
+    do {                                                                \
+        uint32_t total;                                                 \
+        BENCH8_TIME( total, EXPR);                                      \
+        bench8_row( print, NAME, total, overhead);                      \
+    } while(0)
+
+void bench8_run( bench8_print_fn print)
+{
+    bench8_init();
+
+    CRandomStream rng( 8, 0);
+    rng.fill8( in8, sizeof(in8));
+    rng.fill16( in16, sizeof(in16) / sizeof(in16[0]));
+
+    uint32_t overhead;
+    BENCH8_TIME( overhead, a ^ b ^ w);
+
+    char line[64];
+    snprintf( line, sizeof(line), "%s per call; net excludes the bare loop\r\n", bench8_units());
+    print( line);
+    snprintf( line, sizeof(line), "%-22s %8s %8s\r\n", "primitive", "gross", "net");
+    print( line);
+    bench8_row( print, "(bare loop)", overhead, overhead);
+
+    BENCH8_ROW( "scale8",            scale8( a, b));
+    BENCH8_ROW( "scale8_video",      scale8_video( a, b));
+    BENCH8_ROW( "scale16by8",        scale16by8( w, a));
+    BENCH8_ROW( "scale16",           scale16( w, in16[ b ]));
+    BENCH8_ROW( "qadd8",             qadd8( a, b));
+    BENCH8_ROW( "qsub8",             qsub8( a, b));
+    BENCH8_ROW( "avg8",              avg8( a, b));
+    BENCH8_ROW( "mul8",              mul8( a, b));
+    BENCH8_ROW( "qmul8",             qmul8( a, b));
+    BENCH8_ROW( "dim8_video",        dim8_video( a));
+    BENCH8_ROW( "sin8_C",            sin8_C( a));
+    BENCH8_ROW( "sin8_LUT",          sin8_LUT( a));
+    BENCH8_ROW( "sin16_C",           (uint16_t)sin16_C( w));
+    BENCH8_ROW( "sin16_LUT",         (uint16_t)sin16_LUT( w));
+    BENCH8_ROW( "triwave8",          triwave8( a));
+    BENCH8_ROW( "quadwave8",         quadwave8( a));
+    BENCH8_ROW( "cubicwave8",        cubicwave8( a));
+    BENCH8_ROW( "ease8InOutQuad",    ease8InOutQuad( a));
+    BENCH8_ROW( "ease8InOutCubic",   ease8InOutCubic( a));
+    BENCH8_ROW( "ease8InOutApprox",  ease8InOutApprox( a));
+    BENCH8_ROW( "lerp8by8",          lerp8by8( a, b, in8[ w & 0xFF ]));
+    BENCH8_ROW( "lerp16by8",         lerp16by8( w, in16[ a ], b));
+    BENCH8_ROW( "lerp16by16",        lerp16by16( w, in16[ a ], in16[ b ]));
+    BENCH8_ROW( "lerp15by16",        (uint16_t)lerp15by16( w, in16[ a ], in16[ b ]));
+    BENCH8_ROW( "map8",              map8( a, b, 200));
+    BENCH8_ROW( "sqrt16",            sqrt16( w));
+    BENCH8_ROW( "random8",           random8());
+    BENCH8_ROW( "random16",          random16());
+    BENCH8_ROW( "CRandomStream::r16", rng.random16());
+    BENCH8_ROW( "beat88",            beat88( w));
+    BENCH8_ROW( "beatsin8",          beatsin8( a, 0, b));
+    BENCH8_ROW( "beatsin16",         beatsin16( a, 0, w));
+
+    // the array forms, per byte, on a 256-byte scratch buffer
+    {
+        static uint8_t buf[256];
+        memcpy( buf, in8, sizeof(buf));
+        uint32_t total = 0xFFFFFFFF;
+        for( uint8_t run = 0; run < BENCH8_RUNS; run++) {
+            uint32_t t0 = bench8_cycles();
+            for( uint16_t n = 0; n < BENCH8_ITERATIONS; n += 256) {
+                scale8_array( buf, sizeof(buf), 255);
+            }
+            uint32_t t = bench8_cycles() - t0;
+            if( t < total) total = t;
+        }
+        bench8_row( print, "scale8_array (/byte)", total, 0);
+    }
+}
+
+FASTLED_NAMESPACE_END
@@ -0,0 +1,52 @@
+#ifndef __INC_BENCH8_H
+#define __INC_BENCH8_H
+
+#include "FastLED.h"
+
+FASTLED_NAMESPACE_BEGIN
+
+// Cycle-cost micro-benchmark for the lib8tion primitives.
+//
+// bench8_run() times each primitive over BENCH8_ITERATIONS calls with
+// varying inputs, keeps the best of BENCH8_RUNS passes to drop
+// interrupt noise, and prints one line per primitive: cycles per
+// call both with and without the cost of the bare benchmark loop.
+//
+// Cycles are counted with:
+//   - the DWT CYCCNT counter on ARM Cortex-M (core clock cycles; the
+//     same counter the clockless controllers use, so don't run this
+//     during a FastLED.show() on another thread),
+//   - rdtsc on x86 hosts (TSC reference cycles, which may differ
+//     from the core clock under frequency scaling),
+//   - micros() anywhere else, in which case the units are µs.
+//
+// Output goes through a callback so that the same code can print to
+// Serial on a device or stdout on a host:
+//   bench8_run( [](const char * s) { Serial.print(s); });
+//   bench8_run( [](const char * s) { fputs(s, stdout); });
+
+#ifndef BENCH8_ITERATIONS
+#define BENCH8_ITERATIONS 4096
+#endif
+
+#ifndef BENCH8_RUNS
+#define BENCH8_RUNS 3
+#endif
+
+typedef void (*bench8_print_fn)( const char * text);
+
+// Start the cycle counter; bench8_run() calls this itself.
+void bench8_init();
+
+// Read the cycle counter.
+uint32_t bench8_cycles();
+
+// Name of the unit bench8_cycles() counts in.
+const char * bench8_units();
+
+// Time every primitive and print the table.
+void bench8_run( bench8_print_fn print);
+
+FASTLED_NAMESPACE_END
+
+#endif
@@ -38,13 +38,16 @@ void fill_rainbow( struct CRGB * pFirstLED, int numToFill,
                   uint8_t initialhue,
                   uint8_t deltahue )
 {
-    CHSV hsv;
-    hsv.hue = initialhue;
-    hsv.val = 255;
-    hsv.sat = 240;
-    for( int i = 0; i < numToFill; i++) {
-        pFirstLED[i] = hsv;
-        hsv.hue += deltahue;
+    // converted a block at a time with the bulk hsv2rgb_rainbow
+    CHSV hsv[16];
+    uint8_t hue = initialhue;
+    for( int i = 0; i < numToFill; i += 16) {
+        int n = (numToFill - i < 16) ? (numToFill - i) : 16;
+        for( int k = 0; k < n; k++) {
+            hsv[k] = CHSV( hue, 240, 255);
+            hue += deltahue;
+        }
+        hsv2rgb_rainbow( hsv, pFirstLED + i, n);
     }
 }
 
@@ -63,48 +66,138 @@ void fill_rainbow( struct CHSV * targetArray, int numToFill,
 }
 
 
-void fill_gradient_RGB( CRGB* leds,
-                   uint16_t startpos, CRGB startcolor,
-                   uint16_t endpos,   CRGB endcolor )
+// 16.16 start value and per-pixel step for one channel of a gradient;
+// see the note above CHSVGradientSteps.
+static inline void gradient_step( uint8_t from, int16_t change, int32_t divisor,
+                                  accum1616& acc, saccum1516& step)
+{
+    acc  = ((accum1616)from << 16) + 0x8000;
+    step = ((saccum1516)change * 65536) / divisor;
+}
+
+void fill_gradient_steps( CHSVGradientSteps& g,
+                          uint16_t startpos, CHSV startcolor,
+                          uint16_t endpos,   CHSV endcolor,
+                          TGradientDirectionCode directionCode)
 {
     // if the points are in the wrong order, straighten them
     if( endpos < startpos ) {
         uint16_t t = endpos;
-        CRGB tc = endcolor;
+        CHSV tc = endcolor;
         endcolor = startcolor;
         endpos = startpos;
         startpos = t;
         startcolor = tc;
     }
 
-    saccum87 rdistance87;
-    saccum87 gdistance87;
-    saccum87 bdistance87;
+    // If we're fading toward black (val=0) or white (sat=0),
+    // then set the endhue to the starthue.
+    // This lets us ramp smoothly to black or white, regardless
+    // of what 'hue' was set in the endcolor (since it doesn't matter)
+    if( endcolor.value == 0 || endcolor.saturation == 0) {
+        endcolor.hue = startcolor.hue;
+    }
+
+    // Similarly, if we're fading in from black (val=0) or white (sat=0)
+    // then set the starthue to the endhue.
+    // This lets us ramp smoothly up from black or white, regardless
+    // of what 'hue' was set in the startcolor (since it doesn't matter)
+    if( startcolor.value == 0 || startcolor.saturation == 0) {
+        startcolor.hue = endcolor.hue;
+    }
+
+    uint8_t huedelta8 = endcolor.hue - startcolor.hue;
 
-    rdistance87 = (endcolor.r - startcolor.r) << 7;
-    gdistance87 = (endcolor.g - startcolor.g) << 7;
-    bdistance87 = (endcolor.b - startcolor.b) << 7;
+    if( directionCode == SHORTEST_HUES ) {
+        directionCode = FORWARD_HUES;
+        if( huedelta8 > 127) {
+            directionCode = BACKWARD_HUES;
+        }
+    }
+
+    if( directionCode == LONGEST_HUES ) {
+        directionCode = FORWARD_HUES;
+        if( huedelta8 < 128) {
+            directionCode = BACKWARD_HUES;
+        }
+    }
+
+    int16_t huedistance;
+    if( directionCode == FORWARD_HUES) {
+        huedistance = huedelta8;
+    }
+    else /* directionCode == BACKWARD_HUES */
+    {
+        huedistance = -(int16_t)(uint8_t)(256 - huedelta8);
+    }
 
     uint16_t pixeldistance = endpos - startpos;
-    int16_t divisor = pixeldistance ? pixeldistance : 1;
+    int32_t divisor = pixeldistance ? pixeldistance : 1;
 
-    saccum87 rdelta87 = rdistance87 / divisor;
-    saccum87 gdelta87 = gdistance87 / divisor;
-    saccum87 bdelta87 = bdistance87 / divisor;
+    g.startpos = startpos;
+    g.endpos = endpos;
+    gradient_step( startcolor.hue, huedistance, divisor, g.hue, g.huestep);
+    gradient_step( startcolor.sat, endcolor.sat - startcolor.sat, divisor, g.sat, g.satstep);
+    gradient_step( startcolor.val, endcolor.val - startcolor.val, divisor, g.val, g.valstep);
+}
 
-    rdelta87 *= 2;
-    gdelta87 *= 2;
-    bdelta87 *= 2;
 
-    accum88 r88 = startcolor.r << 8;
-    accum88 g88 = startcolor.g << 8;
-    accum88 b88 = startcolor.b << 8;
-    for( uint16_t i = startpos; i <= endpos; i++) {
-        leds[i] = CRGB( r88 >> 8, g88 >> 8, b88 >> 8);
-        r88 += rdelta87;
-        g88 += gdelta87;
-        b88 += bdelta87;
+// Fills 'count' pixels with an RGB gradient that starts at 'from' and
+// reaches 'to' after 'distance' pixels.
+static CRGB* fill_gradient_RGB_run( CRGB* leds, uint32_t count,
+                                    const CRGB& from, const CRGB& to, uint16_t distance)
+{
+    int32_t divisor = distance ? distance : 1;
+    accum1616 r, g, b;
+    saccum1516 rstep, gstep, bstep;
+    gradient_step( from.r, to.r - from.r, divisor, r, rstep);
+    gradient_step( from.g, to.g - from.g, divisor, g, gstep);
+    gradient_step( from.b, to.b - from.b, divisor, b, bstep);
+
+    while( count--) {
+        leds->r = r >> 16;
+        leds->g = g >> 16;
+        leds->b = b >> 16;
+        leds++;
+        r += rstep;
+        g += gstep;
+        b += bstep;
     }
+    return leds;
+}
+
+void fill_gradient_RGB( CRGB* leds,
+                   uint16_t startpos, CRGB startcolor,
+                   uint16_t endpos,   CRGB endcolor )
+{
+    // if the points are in the wrong order, straighten them
+    if( endpos < startpos ) {
+        uint16_t t = endpos;
+        CRGB tc = endcolor;
+        endcolor = startcolor;
+        endpos = startpos;
+        startpos = t;
+        startcolor = tc;
+    }
+
+    uint16_t pixeldistance = endpos - startpos;
+    fill_gradient_RGB_run( leds + startpos, (uint32_t)pixeldistance + 1,
+                           startcolor, endcolor, pixeldistance);
+}
+
+void fill_gradient_RGB( CRGB* leds, const CRGBGradientStop* stops, uint8_t numStops)
+{
+    if( numStops == 0) return;
+
+    // a stop before the one ahead of it ends the list there
+    CRGB* p = leds + stops[0].pos;
+    uint8_t s = 1;
+    for( ; s < numStops && stops[s].pos >= stops[s-1].pos; s++) {
+        uint16_t pixeldistance = stops[s].pos - stops[s-1].pos;
+        p = fill_gradient_RGB_run( p, pixeldistance,
+                                   stops[s-1].color, stops[s].color, pixeldistance);
+    }
+    *p = stops[s-1].color;
 }
 
 #if 0
@@ -153,8 +246,8 @@ void fill_gradient_RGB( CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB
 {
     uint16_t half = (numLeds / 2);
     uint16_t last = numLeds - 1;
-    fill_gradient_RGB( leds,    0, c1, half, c2);
-    fill_gradient_RGB( leds, half, c2, last, c3);
+    CRGBGradientStop stops[3] = { { 0, c1 }, { half, c2 }, { last, c3 } };
+    fill_gradient_RGB( leds, stops, 3);
 }
 
 void fill_gradient_RGB( CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4)
@@ -162,19 +255,18 @@ void fill_gradient_RGB( CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB
     uint16_t onethird = (numLeds / 3);
     uint16_t twothirds = ((numLeds * 2) / 3);
     uint16_t last = numLeds - 1;
-    fill_gradient_RGB( leds,         0, c1,  onethird, c2);
-    fill_gradient_RGB( leds,  onethird, c2, twothirds, c3);
-    fill_gradient_RGB( leds, twothirds, c3,      last, c4);
+    CRGBGradientStop stops[4] = { { 0, c1 }, { onethird, c2 }, { twothirds, c3 }, { last, c4 } };
+    fill_gradient_RGB( leds, stops, 4);
 }
 
 
 
 
+// The bulk scaling functions work on the raw r,g,b bytes of the
+// whole array at once, via the array forms in lib8tion.
 void nscale8_video( CRGB* leds, uint16_t num_leds, uint8_t scale)
 {
-    for( uint16_t i = 0; i < num_leds; i++) {
-        leds[i].nscale8_video( scale);
-    }
+    scale8_video_array( (uint8_t*)leds, (uint32_t)num_leds * 3, scale);
 }
 
 void fade_video(CRGB* leds, uint16_t num_leds, uint8_t fadeBy)
@@ -205,9 +297,7 @@ void nscale8_raw( CRGB* leds, uint16_t num_leds, uint8_t scale)
 
 void nscale8( CRGB* leds, uint16_t num_leds, uint8_t scale)
 {
-    for( uint16_t i = 0; i < num_leds; i++) {
-        leds[i].nscale8( scale);
-    }
+    scale8_array( (uint8_t*)leds, (uint32_t)num_leds * 3, scale);
 }
 
 void fadeUsingColor( CRGB* leds, uint16_t numLeds, const CRGB& colormask)
@@ -427,6 +517,233 @@ void blurColumns(CRGB* leds, uint8_t width, uint8_t height, fract8 blur_amount)
 }
 
 
+// One pixel of the blur_amount filter: blurs 'p' and hands part of
+// its light back to the pixel before it ('prev', if any) and on to
+// the pixel after it (through 'carryover').
+static inline void blur_step( CRGB* p, CRGB* prev, CRGB& carryover, uint8_t keep, uint8_t seep)
+{
+    CRGB cur = *p;
+    CRGB part = cur;
+    part.nscale8( seep);
+    cur.nscale8( keep);
+    cur += carryover;
+    if( prev) *prev += part;
+    *p = cur;
+    carryover = part;
+}
+
+void blur2d( CRGB* leds, const CMatrixLayout& layout, fract8 blur_amount)
+{
+    blurRows( leds, layout, blur_amount);
+    blurColumns( leds, layout, blur_amount);
+}
+
+void blurRows( CRGB* leds, const CMatrixLayout& layout, fract8 blur_amount)
+{
+    // The filter is symmetric, so a serpentine row can be blurred
+    // in memory order just like a row-major one.
+    if( layout.type != MATRIX_MAPPED) {
+        for( uint8_t row = 0; row < layout.height; row++) {
+            blur1d( leds + (uint16_t)row * layout.width, layout.width, blur_amount);
+        }
+        return;
+    }
+
+    uint8_t keep = 255 - blur_amount;
+    uint8_t seep = blur_amount >> 1;
+    for( uint8_t row = 0; row < layout.height; row++) {
+        CRGB carryover = CRGB::Black;
+        CRGB* prev = NULL;
+        for( uint8_t col = 0; col < layout.width; col++) {
+            CRGB* p = leds + layout.index( col, row);
+            blur_step( p, prev, carryover, keep, seep);
+            prev = p;
+        }
+    }
+}
+
+void blurColumns( CRGB* leds, const CMatrixLayout& layout, fract8 blur_amount)
+{
+    uint8_t keep = 255 - blur_amount;
+    uint8_t seep = blur_amount >> 1;
+    CRGB carryover[FASTLED_BLUR_BLOCK];
+    CRGB* prev[FASTLED_BLUR_BLOCK];
+
+    for( uint16_t col0 = 0; col0 < layout.width; col0 += FASTLED_BLUR_BLOCK) {
+        uint8_t lanes = layout.width - col0;
+        if( lanes > FASTLED_BLUR_BLOCK) lanes = FASTLED_BLUR_BLOCK;
+        for( uint8_t j = 0; j < lanes; j++) {
+            carryover[j] = CRGB::Black;
+            prev[j] = NULL;
+        }
+        for( uint8_t row = 0; row < layout.height; row++) {
+            for( uint8_t j = 0; j < lanes; j++) {
+                CRGB* p = leds + layout.index( col0 + j, row);
+                blur_step( p, prev[j], carryover[j], keep, seep);
+                prev[j] = p;
+            }
+        }
+    }
+}
+
+
+// Kernel blurs.  Each line (a row, or one column of a block) keeps the
+// original values of the 2*radius+1 pixels under the kernel in a ring
+// buffer.  The ring is stored twice over, so the window always starts
+// at ring[head] and runs straight on without wrapping.
+
+#define BLUR_TAPS_MAX (2 * FASTLED_BLUR_MAX_RADIUS + 1)
+
+struct CBlurLine {
+    CRGB ring[2 * BLUR_TAPS_MAX];
+    uint8_t head;
+};
+
+// Weights for the kernel, summing to 65536.  Returns the tap count.
+static uint8_t blur_kernel_weights( uint16_t* w, TBlurKernel kernel, uint8_t radius)
+{
+    uint8_t taps = 2 * radius + 1;
+    if( kernel == BLUR_GAUSSIAN) {
+        // row 2*radius of Pascal's triangle, times 65536 / 4^radius
+        uint32_t c = 1;
+        for( uint8_t k = 0; k < taps; k++) {
+            w[k] = c << (16 - 2 * radius);
+            c = c * (taps - 1 - k) / (k + 1);
+        }
+    } else {
+        uint16_t each = 65536L / taps;
+        for( uint8_t k = 0; k < taps; k++) {
+            w[k] = each;
+        }
+        w[radius] += 65536L - (uint32_t)each * taps;
+    }
+    return taps;
+}
+
+static inline void blur_line_push( CBlurLine& line, uint8_t taps, const CRGB& v)
+{
+    line.ring[line.head] = v;
+    line.ring[line.head + taps] = v;
+    line.head++;
+    if( line.head == taps) line.head = 0;
+}
+
+static inline CRGB blur_line_output( const CBlurLine& line, const uint16_t* w, uint8_t taps)
+{
+    uint32_t r = 0x8000, g = 0x8000, b = 0x8000;
+    const CRGB* px = line.ring + line.head;
+    for( uint8_t k = 0; k < taps; k++) {
+        r += (uint32_t)w[k] * px[k].r;
+        g += (uint32_t)w[k] * px[k].g;
+        b += (uint32_t)w[k] * px[k].b;
+    }
+    return CRGB( r >> 16, g >> 16, b >> 16);
+}
+
+// Where pixel i of line j of the current batch lives in leds[].
+struct CBlurRunIndex {           // one contiguous run
+    uint16_t base;
+    inline uint16_t operator()( uint8_t, uint16_t i) const { return base + i; }
+};
+struct CBlurRowIndex {           // one row of a mapped layout
+    const CMatrixLayout& layout;
+    uint8_t row;
+    inline uint16_t operator()( uint8_t, uint16_t i) const { return layout.index( i, row); }
+};
+struct CBlurColumnIndex {        // a block of columns side by side
+    const CMatrixLayout& layout;
+    uint8_t col0;
+    inline uint16_t operator()( uint8_t j, uint16_t i) const { return layout.index( col0 + j, i); }
+};
+
+// Blur 'lanes' lines of 'length' pixels side by side, in place.
+template<uint8_t LANES, class INDEX>
+static void blur_kernel_lines( CRGB* leds, const INDEX& index, uint8_t lanes, uint16_t length,
+                               const uint16_t* w, uint8_t radius)
+{
+    uint8_t taps = 2 * radius + 1;
+    uint16_t last = length - 1;
+    CBlurLine lines[LANES];
+
+    // positions -radius .. radius around pixel 0, clamped to the line
+    for( uint8_t j = 0; j < lanes; j++) {
+        lines[j].head = 0;
+        for( uint8_t k = 0; k < taps; k++) {
+            uint16_t pos = (k < radius) ? 0 : (k - radius);
+            if( pos > last) pos = last;
+            blur_line_push( lines[j], taps, leds[ index( j, pos) ]);
+        }
+    }
+
+    for( uint16_t i = 0; i < length; i++) {
+        uint16_t next = i + radius + 1;
+        if( next > last) next = last;
+        for( uint8_t j = 0; j < lanes; j++) {
+            CRGB out = blur_line_output( lines[j], w, taps);
+            // 'next' is still unwritten: it's past i, or the last pixel
+            // while i hasn't reached it yet
+            if( i != last) blur_line_push( lines[j], taps, leds[ index( j, next) ]);
+            leds[ index( j, i) ] = out;
+        }
+    }
+}
+
+static uint8_t blur_clamp_radius( uint8_t radius)
+{
+    return (radius > FASTLED_BLUR_MAX_RADIUS) ? FASTLED_BLUR_MAX_RADIUS : radius;
+}
+
+void blur1d( CRGB* leds, uint16_t numLeds, TBlurKernel kernel, uint8_t radius)
+{
+    radius = blur_clamp_radius( radius);
+    if( radius == 0 || numLeds == 0) return;
+    uint16_t w[BLUR_TAPS_MAX];
+    blur_kernel_weights( w, kernel, radius);
+    CBlurRunIndex run = { 0 };
+    blur_kernel_lines<1>( leds, run, 1, numLeds, w, radius);
+}
+
+void blur2d( CRGB* leds, const CMatrixLayout& layout, TBlurKernel kernel, uint8_t radius)
+{
+    blurRows( leds, layout, kernel, radius);
+    blurColumns( leds, layout, kernel, radius);
+}
+
+void blurRows( CRGB* leds, const CMatrixLayout& layout, TBlurKernel kernel, uint8_t radius)
+{
+    radius = blur_clamp_radius( radius);
+    if( radius == 0 || layout.width == 0) return;
+    uint16_t w[BLUR_TAPS_MAX];
+    blur_kernel_weights( w, kernel, radius);
+
+    for( uint8_t row = 0; row < layout.height; row++) {
+        if( layout.type != MATRIX_MAPPED) {
+            // symmetric kernel: serpentine rows blur fine backwards
+            CBlurRunIndex run = { (uint16_t)(row * layout.width) };
+            blur_kernel_lines<1>( leds, run, 1, layout.width, w, radius);
+        } else {
+            CBlurRowIndex rowindex = { layout, row };
+            blur_kernel_lines<1>( leds, rowindex, 1, layout.width, w, radius);
+        }
+    }
+}
+
+void blurColumns( CRGB* leds, const CMatrixLayout& layout, TBlurKernel kernel, uint8_t radius)
+{
+    radius = blur_clamp_radius( radius);
+    if( radius == 0 || layout.height == 0) return;
+    uint16_t w[BLUR_TAPS_MAX];
+    blur_kernel_weights( w, kernel, radius);
+
+    for( uint16_t col0 = 0; col0 < layout.width; col0 += FASTLED_BLUR_BLOCK) {
+        uint8_t lanes = layout.width - col0;
+        if( lanes > FASTLED_BLUR_BLOCK) lanes = FASTLED_BLUR_BLOCK;
+        CBlurColumnIndex columns = { layout, (uint8_t)col0 };
+        blur_kernel_lines<FASTLED_BLUR_BLOCK>( leds, columns, lanes, layout.height, w, radius);
+    }
+}
+
+
 
 // CRGB HeatColor( uint8_t temperature)
 //
@@ -771,21 +1088,102 @@ uint8_t applyGamma_video( uint8_t brightness, float gamma)
     return result;
 }
 
+// Most-recently-built gamma tables, replaced round-robin.
+static float   gGammaCacheKey[FASTLED_GAMMA_CACHE_SIZE];
+static uint8_t gGammaCacheTable[FASTLED_GAMMA_CACHE_SIZE][256];
+static uint8_t gGammaCacheCount = 0;
+static uint8_t gGammaCacheNext = 0;
+
+static void build_gamma8_table( uint8_t* table, float gamma)
+{
+    table[0] = 0;
+    for( uint16_t i = 1; i < 256; i++) {
+        table[i] = applyGamma_video( (uint8_t)i, gamma);
+    }
+}
+
+#if FASTLED_GAMMA_CACHE_SIZE < 3 || FASTLED_GAMMA_CACHE_SIZE > 8
+#error "FASTLED_GAMMA_CACHE_SIZE must be 3..8, to hold the R, G and B tables at once"
+#endif
+
+// The cache slot holding the table for gamma, or -1.
+static int8_t find_gamma8_table( float gamma)
+{
+    for( uint8_t i = 0; i < gGammaCacheCount; i++) {
+        if( gGammaCacheKey[i] == gamma) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Build the table for gamma into a free slot, or else the oldest one
+// that isn't in 'keep' (a bit per slot), and return the slot.
+static uint8_t add_gamma8_table( float gamma, uint8_t keep)
+{
+    uint8_t slot;
+    if( gGammaCacheCount < FASTLED_GAMMA_CACHE_SIZE) {
+        slot = gGammaCacheCount++;
+    } else {
+        slot = gGammaCacheNext;
+        while( keep & (1 << slot)) {
+            slot = (slot + 1) % FASTLED_GAMMA_CACHE_SIZE;
+        }
+    }
+    gGammaCacheNext = (slot + 1) % FASTLED_GAMMA_CACHE_SIZE;
+    gGammaCacheKey[slot] = gamma;
+    build_gamma8_table( gGammaCacheTable[slot], gamma);
+    return slot;
+}
+
+const uint8_t* gamma8_table_video( float gamma)
+{
+    int8_t slot = find_gamma8_table( gamma);
+    if( slot < 0) {
+        slot = add_gamma8_table( gamma, 0);
+    }
+    return gGammaCacheTable[slot];
+}
+
+// As gamma8_table_video() for all three channels at once.  Calling that
+// three times in a row isn't the same: building the second or third
+// table can evict the slot the first one was handed out in.  Here the
+// tables already found are kept while the missing ones are built.
+static void gamma8_tables_video( const float gamma[3], const uint8_t* table[3])
+{
+    int8_t slot[3];
+    uint8_t keep = 0;
+    for( uint8_t c = 0; c < 3; c++) {
+        slot[c] = find_gamma8_table( gamma[c]);
+        if( slot[c] >= 0) {
+            keep |= 1 << slot[c];
+        }
+    }
+    for( uint8_t c = 0; c < 3; c++) {
+        if( slot[c] < 0) {
+            // (the same gamma may have been built for an earlier channel)
+            slot[c] = find_gamma8_table( gamma[c]);
+            if( slot[c] < 0) {
+                slot[c] = add_gamma8_table( gamma[c], keep);
+            }
+            keep |= 1 << slot[c];
+        }
+        table[c] = gGammaCacheTable[slot[c]];
+    }
+}
+
 CRGB applyGamma_video( const CRGB& orig, float gamma)
 {
-    CRGB adj;
-    adj.r = applyGamma_video( orig.r, gamma);
-    adj.g = applyGamma_video( orig.g, gamma);
-    adj.b = applyGamma_video( orig.b, gamma);
-    return adj;
+    const uint8_t* table = gamma8_table_video( gamma);
+    return CRGB( table[orig.r], table[orig.g], table[orig.b]);
 }
 
 CRGB applyGamma_video( const CRGB& orig, float gammaR, float gammaG, float gammaB)
 {
     CRGB adj;
-    adj.r = applyGamma_video( orig.r, gammaR);
-    adj.g = applyGamma_video( orig.g, gammaG);
-    adj.b = applyGamma_video( orig.b, gammaB);
+    adj.r = gamma8_table_video( gammaR)[orig.r];
+    adj.g = gamma8_table_video( gammaG)[orig.g];
+    adj.b = gamma8_table_video( gammaB)[orig.b];
     return adj;
 }
 
@@ -803,17 +1201,70 @@ CRGB& napplyGamma_video( CRGB& rgb, float gammaR, float gammaG, float gammaB)
 
 void napplyGamma_video( CRGB* rgbarray, uint16_t count, float gamma)
 {
-    for( uint16_t i = 0; i < count; i++) {
-        rgbarray[i] = applyGamma_video( rgbarray[i], gamma);
-    }
+    napplyGamma_video( rgbarray, count, gamma8_table_video( gamma));
 }
 
 void napplyGamma_video( CRGB* rgbarray, uint16_t count, float gammaR, float gammaG, float gammaB)
+{
+    const float gamma[3] = { gammaR, gammaG, gammaB };
+    const uint8_t* table[3];
+    gamma8_tables_video( gamma, table);
+    napplyGamma_video( rgbarray, count, table[0], table[1], table[2]);
+}
+
+void napplyGamma_video( CRGB* rgbarray, uint16_t count, const uint8_t* table)
+{
+    uint8_t* p = (uint8_t*)rgbarray;
+    for( uint32_t n = (uint32_t)count * 3; n; n--, p++) {
+        *p = table[*p];
+    }
+}
+
+void napplyGamma_video( CRGB* rgbarray, uint16_t count,
+                        const uint8_t* tableR, const uint8_t* tableG, const uint8_t* tableB)
 {
     for( uint16_t i = 0; i < count; i++) {
-        rgbarray[i] = applyGamma_video( rgbarray[i], gammaR, gammaG, gammaB);
+        CRGB& rgb = rgbarray[i];
+        rgb.r = tableR[rgb.r];
+        rgb.g = tableG[rgb.g];
+        rgb.b = tableB[rgb.b];
     }
 }
 
+void CGammaLUT::build( float gammaR, float gammaG, float gammaB)
+{
+    build_gamma8_table( r, gammaR);
+    build_gamma8_table( g, gammaG);
+    build_gamma8_table( b, gammaB);
+}
+
+
+#if 0
+// TEST / VERIFICATION CODE ONLY BELOW THIS POINT
+#include <Arduino.h>
+
+// Checks every cached and compile-time gamma table entry against the
+// float reference, applyGamma_video( uint8_t, float).
+void testgamma()
+{
+    delay(5000);
+    uint16_t mismatches = 0;
+    for( uint16_t g100 = 100; g100 <= 300; g100 += 5) {
+        float gamma = g100 / 100.0;
+        const uint8_t* table = gamma8_table_video( gamma);
+        for( uint16_t i = 0; i < 256; i++) {
+            if( table[i] != applyGamma_video( (uint8_t)i, gamma)) mismatches++;
+        }
+    }
+    const uint8_t* ct = gamma8_table_const<220>();
+    for( uint16_t i = 0; i < 256; i++) {
+        if( ct[i] != applyGamma_video( (uint8_t)i, (float)(220 / 100.0))) mismatches++;
+    }
+    Serial.print("gamma table mismatches: "); Serial.println(mismatches);
+    Serial.println("done.");
+    for(;;){};
+}
+
+#endif
 
 FASTLED_NAMESPACE_END
@@ -59,6 +59,38 @@ typedef enum { FORWARD_HUES, BACKWARD_HUES, SHORTEST_HUES, LONGEST_HUES } TGradi
 
 #define saccum87 int16_t
 
+// Gradients are stepped along the strip with 16.16 accumulators, so
+// the only division is the one per channel when a gradient is set up;
+// there is none per pixel.  fill_gradient_steps does that setup for
+// the HSV forms: it puts the two ends in order, picks which way the
+// hue goes, and fills in a CHSVGradientSteps.  The accumulators start
+// half a step up, so the last pixel lands exactly on the end color.
+struct CHSVGradientSteps {
+    uint16_t   startpos;
+    uint16_t   endpos;
+    accum1616  hue, sat, val;
+    saccum1516 huestep, satstep, valstep;
+};
+
+void fill_gradient_steps( CHSVGradientSteps& steps,
+                          uint16_t startpos, CHSV startcolor,
+                          uint16_t endpos,   CHSV endcolor,
+                          TGradientDirectionCode directionCode);
+
+// Writes 'count' pixels of the gradient in 'steps', from p onward,
+// and returns the pixel after the last one written.
+template <typename T>
+T* fill_gradient_run( T* p, CHSVGradientSteps& steps, uint32_t count)
+{
+    while( count--) {
+        *p++ = CHSV( steps.hue >> 16, steps.sat >> 16, steps.val >> 16);
+        steps.hue += steps.huestep;
+        steps.sat += steps.satstep;
+        steps.val += steps.valstep;
+    }
+    return p;
+}
+
 /// fill_gradient - fill an array of colors with a smooth HSV gradient
 /// between two specified HSV colors.
 /// Since 'hue' is a value around a color wheel,
@@ -89,84 +121,9 @@ void fill_gradient( T* targetArray,
                     uint16_t endpos,   CHSV endcolor,
                     TGradientDirectionCode directionCode  = SHORTEST_HUES )
 {
-    // if the points are in the wrong order, straighten them
-    if( endpos < startpos ) {
-        uint16_t t = endpos;
-        CHSV tc = endcolor;
-        endcolor = startcolor;
-        endpos = startpos;
-        startpos = t;
-        startcolor = tc;
-    }
-
-    // If we're fading toward black (val=0) or white (sat=0),
-    // then set the endhue to the starthue.
-    // This lets us ramp smoothly to black or white, regardless
-    // of what 'hue' was set in the endcolor (since it doesn't matter)
-    if( endcolor.value == 0 || endcolor.saturation == 0) {
-        endcolor.hue = startcolor.hue;
-    }
-
-    // Similarly, if we're fading in from black (val=0) or white (sat=0)
-    // then set the starthue to the endhue.
-    // This lets us ramp smoothly up from black or white, regardless
-    // of what 'hue' was set in the startcolor (since it doesn't matter)
-    if( startcolor.value == 0 || startcolor.saturation == 0) {
-        startcolor.hue = endcolor.hue;
-    }
-
-    saccum87 huedistance87;
-    saccum87 satdistance87;
-    saccum87 valdistance87;
-
-    satdistance87 = (endcolor.sat - startcolor.sat) << 7;
-    valdistance87 = (endcolor.val - startcolor.val) << 7;
-
-    uint8_t huedelta8 = endcolor.hue - startcolor.hue;
-
-    if( directionCode == SHORTEST_HUES ) {
-        directionCode = FORWARD_HUES;
-        if( huedelta8 > 127) {
-            directionCode = BACKWARD_HUES;
-        }
-    }
-
-    if( directionCode == LONGEST_HUES ) {
-        directionCode = FORWARD_HUES;
-        if( huedelta8 < 128) {
-            directionCode = BACKWARD_HUES;
-        }
-    }
-
-    if( directionCode == FORWARD_HUES) {
-        huedistance87 = huedelta8 << 7;
-    }
-    else /* directionCode == BACKWARD_HUES */
-    {
-        huedistance87 = (uint8_t)(256 - huedelta8) << 7;
-        huedistance87 = -huedistance87;
-    }
-
-    uint16_t pixeldistance = endpos - startpos;
-    int16_t divisor = pixeldistance ? pixeldistance : 1;
-
-    saccum87 huedelta87 = huedistance87 / divisor;
-    saccum87 satdelta87 = satdistance87 / divisor;
-    saccum87 valdelta87 = valdistance87 / divisor;
-
-    huedelta87 *= 2;
-    satdelta87 *= 2;
-    valdelta87 *= 2;
-
-    accum88 hue88 = startcolor.hue << 8;
-    accum88 sat88 = startcolor.sat << 8;
-    accum88 val88 = startcolor.val << 8;
-    for( uint16_t i = startpos; i <= endpos; i++) {
-        targetArray[i] = CHSV( hue88 >> 8, sat88 >> 8, val88 >> 8);
-        hue88 += huedelta87;
-        sat88 += satdelta87;
-        val88 += valdelta87;
-    }
+    CHSVGradientSteps g;
+    fill_gradient_steps( g, startpos, startcolor, endpos, endcolor, directionCode);
+    fill_gradient_run( targetArray + g.startpos, g, (uint32_t)(g.endpos - g.startpos) + 1);
 }
 
 
@@ -221,6 +178,56 @@ void fill_gradient_RGB( CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB
 void fill_gradient_RGB( CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4);
 
 
+// Multi-segment gradients in one call.  Each stop gives a pixel
+// position and the color at that position; the stops must be in order
+// of increasing position, and the list is taken to end at the first
+// stop that isn't (nothing from there on is drawn).  The pixels from each stop up to the next
+// are filled with a gradient between the two, exactly as if
+// fill_gradient / fill_gradient_RGB had been called on every pair of
+// neighbouring stops, but in a single pass over the strip, with each
+// stop pixel written once (where two stops share a position, the
+// later one wins).
+//   Example:
+//     CRGBGradientStop stops[] = { {  0, CRGB::Red },
+//                                  { 40, CRGB::Gold },
+//                                  { 99, CRGB::Blue } };
+//     fill_gradient_RGB( leds, stops, 3);
+struct CRGBGradientStop {
+    uint16_t pos;
+    CRGB     color;
+};
+
+struct CHSVGradientStop {
+    uint16_t pos;
+    CHSV     color;
+};
+
+void fill_gradient_RGB( CRGB* leds, const CRGBGradientStop* stops, uint8_t numStops);
+
+template <typename T>
+void fill_gradient( T* targetArray, const CHSVGradientStop* stops, uint8_t numStops,
+                    TGradientDirectionCode directionCode = SHORTEST_HUES )
+{
+    if( numStops == 0) return;
+
+    // a stop before the one ahead of it ends the list there
+    CHSVGradientSteps g;
+    T* p = targetArray + stops[0].pos;
+    uint8_t s = 1;
+    for( ; s < numStops && stops[s].pos >= stops[s-1].pos; s++) {
+        fill_gradient_steps( g, stops[s-1].pos, stops[s-1].color,
+                                stops[s].pos,   stops[s].color, directionCode);
+        p = fill_gradient_run( p, g, stops[s].pos - stops[s-1].pos);
+    }
+    if( s == 1) {
+        *p = stops[0].color;
+        return;
+    }
+    // the last stop's own pixel, where the last segment ends
+    fill_gradient_run( p, g, 1);
+}
+
+
 // fadeLightBy and fade_video - reduce the brightness of an array
 //                              of pixels all at once.  Guaranteed
 //                              to never fade all the way to black.
@@ -318,6 +325,82 @@ void blurRows( CRGB* leds, uint8_t width, uint8_t height, fract8 blur_amount);
 void blurColumns(CRGB* leds, uint8_t width, uint8_t height, fract8 blur_amount);
 
 
+// CMatrixLayout describes how a width x height matrix is laid out in a
+// CRGB array, so that the 2D filters don't need the application's XY()
+// function:
+//   MATRIX_ROW_MAJOR    row after row, every row left to right
+//   MATRIX_SERPENTINE   row after row, odd rows right to left
+//   MATRIX_MAPPED       map[y * width + x] holds the led index
+//
+//   CMatrixLayout layout( 16, 16, MATRIX_SERPENTINE);
+//   blur2d( leds, layout, 64);
+typedef enum { MATRIX_ROW_MAJOR=0, MATRIX_SERPENTINE=1, MATRIX_MAPPED=2 } TMatrixLayoutType;
+
+struct CMatrixLayout {
+    uint8_t width;
+    uint8_t height;
+    uint8_t type;
+    const uint16_t* map;
+
+    inline CMatrixLayout( uint8_t w, uint8_t h,
+                          TMatrixLayoutType t = MATRIX_ROW_MAJOR,
+                          const uint16_t* m = NULL)
+        : width(w), height(h), type(t), map(m)
+    {
+    }
+
+    inline uint16_t index( uint8_t x, uint8_t y) const
+    {
+        uint16_t i = (uint16_t)y * width;
+        if( type == MATRIX_ROW_MAJOR) return i + x;
+        if( type == MATRIX_SERPENTINE) return (y & 0x01) ? (i + (width - 1) - x) : (i + x);
+        return map[i + x];
+    }
+
+    inline uint16_t size() const { return (uint16_t)width * height; }
+};
+
+// blur2d, blurRows, blurColumns with a layout: the same filter as the
+// XY() versions above (and the same results, pixel for pixel, given an
+// XY() that matches the layout).  Columns are blurred a block of
+// FASTLED_BLUR_BLOCK columns at a time, walking down the rows, so that
+// each step touches neighboring pixels in memory.
+void blur2d( CRGB* leds, const CMatrixLayout& layout, fract8 blur_amount);
+void blurRows( CRGB* leds, const CMatrixLayout& layout, fract8 blur_amount);
+void blurColumns( CRGB* leds, const CMatrixLayout& layout, fract8 blur_amount);
+
+// Kernel blurs: separable, fixed-point (16-bit weights summing to
+// 65536), radius 1..FASTLED_BLUR_MAX_RADIUS pixels in each direction.
+//   BLUR_BOX        equal weights over 2*radius+1 pixels
+//   BLUR_GAUSSIAN   binomial weights, i.e. a gaussian with
+//                   sigma = sqrt( radius / 2)
+// Pixels past the edges count as copies of the edge pixel, so an even
+// field stays even, right up to the edges, instead of darkening there
+// as with the blur_amount filters.  The total light isn't kept,
+// though: the edge pixels are counted more than once near the ends, so
+// a strip that is brighter at its ends than inside gains light, and
+// one that is darker loses it.
+// They work in place; the only scratch space is a small ring buffer on
+// the stack, a few dozen bytes per column in a block.
+typedef enum { BLUR_BOX=0, BLUR_GAUSSIAN=1 } TBlurKernel;
+
+#ifndef FASTLED_BLUR_MAX_RADIUS
+#define FASTLED_BLUR_MAX_RADIUS 4
+#endif
+#if FASTLED_BLUR_MAX_RADIUS > 8
+#error "FASTLED_BLUR_MAX_RADIUS can be at most 8"
+#endif
+
+#ifndef FASTLED_BLUR_BLOCK
+#define FASTLED_BLUR_BLOCK 8
+#endif
+
+void blur1d( CRGB* leds, uint16_t numLeds, TBlurKernel kernel, uint8_t radius);
+void blur2d( CRGB* leds, const CMatrixLayout& layout, TBlurKernel kernel, uint8_t radius);
+void blurRows( CRGB* leds, const CMatrixLayout& layout, TBlurKernel kernel, uint8_t radius);
+void blurColumns( CRGB* leds, const CMatrixLayout& layout, TBlurKernel kernel, uint8_t radius);
+
+
 // CRGB HeatColor( uint8_t temperature)
 //
 // Approximates a 'black body radiation' spectrum for
@@ -1136,10 +1219,9 @@ void nblendPaletteTowardPalette( CRGBPalette16& currentPalette,
 // - different gamma adjustments for each channel of a CRFB color.
 //
 // Note that the gamma is specified as a traditional floating point value
-// e.g., "2.5", and as such these functions should not be called in
-// your innermost pixel loops, or in animations that are extremely
-// low on program storage space.  Nevertheless, if you need these
-// functions, here they are.
+// e.g., "2.5".  The single-value version calls pow() every time; the CRGB
+// and array versions use cached lookup tables (see below), and are fine
+// to call once per frame.
 //
 // Furthermore, bear in mind that CRGB leds have only eight bits
 // per channel of color resolution, and that very small, subtle shadings
@@ -1154,6 +1236,123 @@ void   napplyGamma_video( CRGB* rgbarray, uint16_t count, float gamma);
 void   napplyGamma_video( CRGB* rgbarray, uint16_t count, float gammaR, float gammaG, float gammaB);
 
 
+// Gamma lookup tables
+//
+// All of the CRGB and array gamma functions above go through 256-entry
+// tables rather than calling pow() per channel: gamma8_table_video()
+// builds the table for a given gamma the first time it's asked for,
+// and keeps the most recent FASTLED_GAMMA_CACHE_SIZE tables around, so
+// after the first frame no floating point math is done at all.  Each
+// table entry is exactly applyGamma_video( i, gamma).
+//
+// The array forms below take tables directly, and make one pass over
+// the pixel data:
+//   napplyGamma_video( leds, NUM_LEDS, gamma8_table_video( 2.2));
+//
+// For a gamma that's fixed at compile time, gamma8_table_const<X100>()
+// returns a table computed entirely by the compiler (C++11 and up),
+// with gamma given in hundredths, e.g. gamma8_table_const<220>() for
+// gamma 2.2.  It lives in flash and costs no RAM or startup time.
+//
+// CGammaLUT holds one table per channel.  Color correction and
+// temperature are left to the controllers, which fold them in with the
+// brightness as they write the data out.
+//   CGammaLUT lut( 2.5, 2.2, 2.0);
+//   ...
+//   lut.apply( leds, NUM_LEDS);
+
+#ifndef FASTLED_GAMMA_CACHE_SIZE
+#define FASTLED_GAMMA_CACHE_SIZE 3
+#endif
+
+const uint8_t* gamma8_table_video( float gamma);
+
+void napplyGamma_video( CRGB* rgbarray, uint16_t count, const uint8_t* table);
+void napplyGamma_video( CRGB* rgbarray, uint16_t count,
+                        const uint8_t* tableR, const uint8_t* tableG, const uint8_t* tableB);
+
+class CGammaLUT {
+public:
+    uint8_t r[256];
+    uint8_t g[256];
+    uint8_t b[256];
+
+    CGammaLUT( float gamma) { build( gamma, gamma, gamma); }
+    CGammaLUT( float gammaR, float gammaG, float gammaB) { build( gammaR, gammaG, gammaB); }
+
+    void build( float gammaR, float gammaG, float gammaB);
+
+    inline void apply( CRGB* rgbarray, uint16_t count) const
+    {
+        napplyGamma_video( rgbarray, count, r, g, b);
+    }
+};
+
+#if __cplusplus >= 201103L
+// constexpr ln(x), x > 0: halve the range down to [0.5,1), then
+// ln(x) = 2 * atanh( (x-1)/(x+1) ), summed as a power series.
+constexpr double gamma8_ce_atanh( double z, double z2, double term, int k)
+{
+    return k > 40 ? 0 : term / (2 * k + 1) + gamma8_ce_atanh( z, z2, term * z2, k + 1);
+}
+constexpr double gamma8_ce_ln( double x)
+{
+    return x < 0.5 ? gamma8_ce_ln( x * 2) - 0.69314718055994530942
+                   : 2 * gamma8_ce_atanh( (x - 1) / (x + 1),
+                                          ((x - 1) / (x + 1)) * ((x - 1) / (x + 1)),
+                                          (x - 1) / (x + 1), 0);
+}
+// constexpr exp(y), y <= 0: exp(y) = exp(y/2)^2 until |y| < 0.5,
+// then a Taylor series.
+constexpr double gamma8_ce_taylor( double y, double term, int k)
+{
+    return k > 20 ? 0 : term + gamma8_ce_taylor( y, term * y / (k + 1), k + 1);
+}
+constexpr double gamma8_ce_square( double v) { return v * v; }
+constexpr double gamma8_ce_exp( double y)
+{
+    return y < -0.5 ? gamma8_ce_square( gamma8_ce_exp( y / 2)) : gamma8_ce_taylor( y, 1, 0);
+}
+// applyGamma_video, at compile time, rounding to float at the same
+// points it does so that the tables come out identical
+constexpr uint8_t gamma8_ce_scaled( float adj)
+{
+    return (uint8_t)(adj) == 0 ? 1 : (uint8_t)(adj);
+}
+constexpr float gamma8_ce_pow( float orig, float gamma)
+{
+    return (float)gamma8_ce_exp( gamma8_ce_ln( orig) * gamma);
+}
+constexpr uint8_t gamma8_ce_video( uint16_t i, uint16_t gammaX100)
+{
+    return i == 0 ? 0
+         : gamma8_ce_scaled( (float)(gamma8_ce_pow( (float)(i / 255.0),
+                                                    (float)(gammaX100 / 100.0)) * 255.0));
+}
+
+template<uint16_t... I> struct gamma8_ce_indices {};
+template<uint16_t N, uint16_t... I> struct gamma8_ce_make_indices
+    : gamma8_ce_make_indices<N - 1, N - 1, I...> {};
+template<uint16_t... I> struct gamma8_ce_make_indices<0, I...> {
+    typedef gamma8_ce_indices<I...> type;
+};
+
+template<uint16_t GAMMA_X100, class INDICES> struct CGammaConstTable;
+template<uint16_t GAMMA_X100, uint16_t... I>
+struct CGammaConstTable<GAMMA_X100, gamma8_ce_indices<I...> > {
+    static constexpr uint8_t table[256] = { gamma8_ce_video( I, GAMMA_X100)... };
+};
+template<uint16_t GAMMA_X100, uint16_t... I>
+constexpr uint8_t CGammaConstTable<GAMMA_X100, gamma8_ce_indices<I...> >::table[256];
+
+template<uint16_t GAMMA_X100> inline const uint8_t* gamma8_table_const()
+{
+    return CGammaConstTable<GAMMA_X100,
+                            typename gamma8_ce_make_indices<256>::type>::table;
+}
+#endif
+
+
 FASTLED_NAMESPACE_END
 
 #endif
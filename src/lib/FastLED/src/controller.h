@@ -16,6 +16,8 @@ FASTLED_NAMESPACE_BEGIN
 
 // operator byte *(struct CRGB[] arr) { return (byte*)arr; }
 
+class CPowerModel;
+
 #define DISABLE_DITHER 0x00
 #define BINARY_DITHER 0x01
 typedef uint8_t EDitherMode;
@@ -39,6 +41,7 @@ protected:
     CRGB m_ColorCorrection;
     CRGB m_ColorTemperature;
     EDitherMode m_DitherMode;
+    const CPowerModel *m_pPowerModel;
     int m_nLeds;
     static CLEDController *m_pHead;
     static CLEDController *m_pTail;
@@ -55,7 +58,7 @@ protected:
     virtual void show(const struct CARGB *data, int nLeds, CRGB scale) = 0;
 #endif
 public:
-    CLEDController() : m_Data(NULL), m_ColorCorrection(UncorrectedColor), m_ColorTemperature(UncorrectedTemperature), m_DitherMode(BINARY_DITHER), m_nLeds(0) {
+    CLEDController() : m_Data(NULL), m_ColorCorrection(UncorrectedColor), m_ColorTemperature(UncorrectedTemperature), m_DitherMode(BINARY_DITHER), m_pPowerModel(NULL), m_nLeds(0) {
         m_pNext = NULL;
         if(m_pHead==NULL) { m_pHead = this; }
         if(m_pTail != NULL) { m_pTail->m_pNext = this; }
@@ -130,6 +133,11 @@ public:
     CLEDController & setTemperature(ColorTemperature temperature) { m_ColorTemperature = temperature; return *this; }
     CRGB getTemperature() { return m_ColorTemperature; }
 
+    // How this controller's leds turn into milliwatts, for the power
+    // governor; NULL (the default) uses the global power calibration.
+    CLEDController & setPowerModel(const CPowerModel *model) { m_pPowerModel = model; return *this; }
+    const CPowerModel *getPowerModel() { return m_pPowerModel; }
+
     CRGB getAdjustment(uint8_t scale) {
 #if defined(NO_CORRECTION) && (NO_CORRECTION==1)
         return CRGB(scale,scale,scale);
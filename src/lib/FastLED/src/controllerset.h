@@ -0,0 +1,141 @@
+#ifndef __INC_CONTROLLERSET_H
+#define __INC_CONTROLLERSET_H
+
+#include "FastLED.h"
+
+FASTLED_NAMESPACE_BEGIN
+
+// A fixed set of controllers, known at compile time.
+//
+// FastLED keeps its controllers in a linked list (CLEDController::head())
+// that each one joins when it's constructed.  FastLED.show() walks the
+// list and calls each controller's show() virtually, and FastLED[i]
+// walks it again to find the i'th one.  With a CControllerSet, the
+// controller types are template arguments instead:
+//
+//   CControllerSet< WS2811<5, RGB>, WS2811<6, RGB> > controllers;
+//
+//   void setup() {
+//       controllers.addLeds<0>( shelf, 99).setCorrection( TypicalLEDStrip);
+//       controllers.addLeds<1>( mantel, 60);
+//   }
+//   void loop() {
+//       ...
+//       controllers.show();      // instead of FastLED.show()
+//   }
+//
+// show() calls each controller's own show() directly, not through the
+// vtable, so the compiler sees the whole of each controller's output
+// path (showRGBInternal and the PixelController it reads from) and
+// can inline it; and controller<i>() is resolved at compile time.
+//
+// The controllers still join the linked list as well, in the order
+// they are listed, so everything that works from the list (FastLED.show(),
+// FastLED[i], setCorrection(), CPowerGovernor, CFramePostProcess, ...)
+// sees them as usual.
+//
+// Needs C++11 (variadic templates).
+
+#if __cplusplus >= 201103L
+
+// CONTROLLER with a non-virtual showLeds().
+template<typename CONTROLLER>
+class CStaticController : public CONTROLLER {
+public:
+    // showLeds(), calling CONTROLLER's show() directly
+    inline void showLedsStatic( uint8_t brightness) {
+        CONTROLLER::show( this->m_Data, this->m_nLeds, this->getAdjustment( brightness));
+    }
+};
+
+template<typename... CONTROLLERS> class CControllerSet;
+template<int I, typename SET> struct CControllerSetAt;
+
+template<>
+class CControllerSet<> {
+public:
+    enum { count = 0 };
+
+    void show( const uint8_t *, uint8_t, uint8_t, bool) {}
+    template<typename F> void forEach( F) {}
+};
+
+template<typename FIRST, typename... REST>
+class CControllerSet<FIRST, REST...> {
+public:
+    enum { count = 1 + CControllerSet<REST...>::count };
+
+    // The I'th controller.
+    template<int I>
+    typename CControllerSetAt<I, CControllerSet>::type & controller() {
+        return CControllerSetAt<I, CControllerSet>::get( *this);
+    }
+
+    // As FastLED.addLeds(), for the I'th controller.
+    template<int I>
+    CLEDController & addLeds( CRGB *data, int nLedsOrOffset, int nLedsIfOffset = 0) {
+        return CFastLED::addLeds( &controller<I>(), data, nLedsOrOffset, nLedsIfOffset);
+    }
+
+    // As FastLED.show(): every controller at the given brightness.
+    void show( uint8_t scale) {
+        FastLED.waitToShow();
+        show( NULL, 0, scale, FastLED.getFPS() < 100);
+        FastLED.countFPS();
+    }
+    void show() { show( FastLED.getBrightness()); }
+
+    // As FastLED.show( scales, nScales): controller i at scales[i];
+    // controllers past nScales at FastLED.getBrightness().
+    void show( const uint8_t *scales, uint8_t nScales) {
+        FastLED.waitToShow();
+        show( scales, nScales, FastLED.getBrightness(), FastLED.getFPS() < 100);
+        FastLED.countFPS();
+    }
+
+    // Call f( controller) for each controller, in order, with its own
+    // static type.
+    template<typename F>
+    void forEach( F f) {
+        f( m_First);
+        m_Rest.forEach( f);
+    }
+
+    // The rest of a show(), from this controller on: the first of
+    // these takes scales[0], or 'scale' if there are none left.
+    // 'slow' is the FPS check of FastLED.show(): below 100 frames a
+    // second, dithering only flickers, so it's turned off.
+    void show( const uint8_t *scales, uint8_t nScales, uint8_t scale, bool slow) {
+        uint8_t d = m_First.getDither();
+        if( slow) { m_First.setDither( 0); }
+        m_First.showLedsStatic( nScales ? scales[0] : scale);
+        m_First.setDither( d);
+        m_Rest.show( nScales ? scales + 1 : scales, nScales ? nScales - 1 : 0, scale, slow);
+    }
+
+private:
+    template<int, typename> friend struct CControllerSetAt;
+
+    // constructed in this order, which is the order they join the list
+    CStaticController<FIRST> m_First;
+    CControllerSet<REST...> m_Rest;
+};
+
+template<typename FIRST, typename... REST>
+struct CControllerSetAt<0, CControllerSet<FIRST, REST...> > {
+    typedef CStaticController<FIRST> type;
+    static type & get( CControllerSet<FIRST, REST...> & set) { return set.m_First; }
+};
+
+template<int I, typename FIRST, typename... REST>
+struct CControllerSetAt<I, CControllerSet<FIRST, REST...> > {
+    typedef CControllerSetAt<I - 1, CControllerSet<REST...> > next;
+    typedef typename next::type type;
+    static type & get( CControllerSet<FIRST, REST...> & set) { return next::get( set.m_Rest); }
+};
+
+#endif
+
+FASTLED_NAMESPACE_END
+
+#endif
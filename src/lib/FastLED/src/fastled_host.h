@@ -0,0 +1,7 @@
+#ifndef __INC_FASTLED_HOST_H
+#define __INC_FASTLED_HOST_H
+
+// See led_sysdefs_host.h.
+#include "delay.h"
+
+#endif
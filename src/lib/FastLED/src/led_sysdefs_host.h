@@ -0,0 +1,52 @@
+#ifndef __INC_LED_SYSDEFS_HOST_H
+#define __INC_LED_SYSDEFS_HOST_H
+
+// A desktop build (-DFASTLED_HOST), for the host checks at the end of
+// some of the .cpp files.  Nothing is driven: there are no pins and no
+// clockless output, and millis() is the host's steady clock.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#define FASTLED_NAMESPACE_BEGIN namespace NSFastLED {
+#define FASTLED_NAMESPACE_END }
+#define FASTLED_USING_NAMESPACE using namespace NSFastLED;
+
+#define cli()
+#define sei()
+
+// pgmspace definitions
+#define PROGMEM
+#define pgm_read_dword(addr) (*(const unsigned long *)(addr))
+#define pgm_read_dword_near(addr) pgm_read_dword(addr)
+
+// data type defs
+typedef volatile       uint8_t RoRg;
+typedef volatile       uint8_t RwRg;
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define FASTLED_NO_PINMAP
+
+#define F_CPU 120000000
+
+#define INPUT  0
+#define OUTPUT 1
+#define LOW    0
+#define HIGH   1
+
+inline uint32_t micros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t millis() { return micros() / 1000; }
+inline void delay( uint32_t) {}
+inline void delayMicroseconds( uint32_t) {}
+inline void pinMode( uint16_t, uint8_t) {}
+inline void digitalWrite( uint16_t, uint8_t) {}
+
+#endif
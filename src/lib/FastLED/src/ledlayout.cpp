@@ -0,0 +1,73 @@
+#define FASTLED_INTERNAL
+#include "FastLED.h"
+
+FASTLED_NAMESPACE_BEGIN
+
+// Point every grid cell at the safety pixel and every led at nowhere.
+static void layout_clear( uint16_t* xy, uint8_t* xs, uint8_t* ys,
+                          uint16_t cells, uint16_t numLeds)
+{
+    for( uint16_t i = 0; i < cells; i++) {
+        xy[i] = numLeds;
+    }
+    memset8( xs, LAYOUT_NOWHERE, numLeds);
+    memset8( ys, LAYOUT_NOWHERE, numLeds);
+}
+
+void layout_build_segments( uint16_t* xy, uint8_t* xs, uint8_t* ys,
+                            uint8_t width, uint8_t height, uint16_t numLeds,
+                            const CLayoutSegment* segments, uint8_t segmentCount)
+{
+    layout_clear( xy, xs, ys, (uint16_t)width * height, numLeds);
+
+    for( uint8_t s = 0; s < segmentCount; s++) {
+        const CLayoutSegment& seg = segments[s];
+        if( seg.y >= height) continue;
+        for( uint8_t k = 0; k < seg.count; k++) {
+            uint16_t led = seg.first + k;
+            uint16_t x = seg.reversed ? (seg.x + seg.count - 1 - k) : (seg.x + k);
+            if( led >= numLeds || x >= width) continue;
+            xy[ (uint16_t)seg.y * width + x] = led;
+            xs[led] = x;
+            ys[led] = seg.y;
+        }
+    }
+}
+
+void layout_build_matrix( uint16_t* xy, uint8_t* xs, uint8_t* ys,
+                          uint8_t width, uint8_t height, uint16_t numLeds,
+                          TMatrixLayoutType type, const uint16_t* map)
+{
+    layout_clear( xy, xs, ys, (uint16_t)width * height, numLeds);
+    if( type == MATRIX_MAPPED && map == NULL) return;
+
+    CMatrixLayout matrix( width, height, type, map);
+    for( uint8_t y = 0; y < height; y++) {
+        for( uint8_t x = 0; x < width; x++) {
+            uint16_t led = matrix.index( x, y);
+            if( led >= numLeds) continue;
+            xy[ (uint16_t)y * width + x] = led;
+            xs[led] = x;
+            ys[led] = y;
+        }
+    }
+}
+
+uint16_t layout_build_order( uint16_t* order, const uint8_t* xs, uint16_t numLeds)
+{
+    uint16_t onGrid = 0;
+    for( uint16_t i = 0; i < numLeds; i++) {
+        if( xs[i] != LAYOUT_NOWHERE) onGrid++;
+    }
+    uint16_t on = 0, off = onGrid;
+    for( uint16_t i = 0; i < numLeds; i++) {
+        if( xs[i] != LAYOUT_NOWHERE) {
+            order[on++] = i;
+        } else {
+            order[off++] = i;
+        }
+    }
+    return onGrid;
+}
+
+FASTLED_NAMESPACE_END
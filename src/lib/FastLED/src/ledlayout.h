@@ -0,0 +1,214 @@
+#ifndef __INC_LEDLAYOUT_H
+#define __INC_LEDLAYOUT_H
+
+#include "colorutils.h"
+
+FASTLED_NAMESPACE_BEGIN
+
+// Physical layouts: where each led of a strip sits on a WIDTH x HEIGHT
+// grid, worked out once into index tables so that effects can find a
+// pixel with a single table load.
+//
+// A layout is built from:
+//   - segments: runs of consecutive leds laid along one row, e.g. one
+//     strip per shelf, or a strip that zig-zags along several shelves,
+//   - a serpentine or row-major matrix,
+//   - a lookup table (map[y * WIDTH + x] = led index), which can sit in
+//     flash as a 'const' array.
+//
+// Grid cells with no led behind them point at the "safety pixel",
+// index NUM_LEDS, so give the layout's CRGB array one spare entry:
+//   CRGB leds_plus_safety_pixel[ NUM_LEDS + 1];
+//   CRGB* const leds( leds_plus_safety_pixel);
+//
+// Example, three shelves wired as one strip, the middle one running
+// right to left:
+//   const CLayoutSegment shelves[] = {
+//       //  first  count  x  y  reversed
+//       {     0,    33,   0, 0, false },
+//       {    33,    33,   0, 1, true  },
+//       {    66,    33,   0, 2, false },
+//   };
+//   CLEDLayout<33, 3, 99> layout( shelves, 3);
+//
+//   blur2d( leds, layout.matrix(), 64);          // 2D filters
+//   fill_2dnoise8( leds, layout.matrix(), ...);
+//   const uint16_t* row = layout.row( y);        // one row at a time
+//   for( uint8_t x = 0; x < 33; x++) leds[ row[x] ] = ...;
+//   for( CLayoutPixel px : layout.pixels()) {    // every led, with
+//       leds[ px.index ] = CHSV( px.x * 8, ...); // its position
+//   }
+//   for( CLayoutPixel px : layout.onGridPixels()) {  // just the leds
+//       leds[ px.index ] = CHSV( px.y * 64, ...);     // on the grid,
+//   }
+//   for( CLayoutPixel px : layout.offGridPixels()) { // and the rest
+//       leds[ px.index ] = CRGB::Black;
+//   }
+//
+// A table that already describes the whole layout doesn't need a
+// CLEDLayout at all; CMatrixLayout can read it straight from flash:
+//   const uint16_t kShelfMap[ 33 * 3] = { ... };
+//   CMatrixLayout shelfMatrix( 33, 3, MATRIX_MAPPED, kShelfMap);
+
+struct CLayoutSegment {
+    uint16_t first;     // index of the segment's first led on the strip
+    uint8_t  count;     // number of leds in the segment
+    uint8_t  x;         // grid column of the leftmost led
+    uint8_t  y;         // grid row
+    bool     reversed;  // true if the leds run right to left
+};
+
+// An led and where it sits on the grid.  Leds that aren't on the grid
+// have x == y == LAYOUT_NOWHERE.
+#define LAYOUT_NOWHERE 0xFF
+
+struct CLayoutPixel {
+    uint16_t index;
+    uint8_t  x;
+    uint8_t  y;
+};
+
+// Iterates over every led in strip order; see CLEDLayout::pixels().
+class CLayoutPixelIterator {
+public:
+    inline CLayoutPixelIterator( const uint8_t* xs, const uint8_t* ys, uint16_t index)
+        : m_xs(xs), m_ys(ys), m_index(index) {}
+
+    inline CLayoutPixel operator*() const
+    {
+        CLayoutPixel px = { m_index, m_xs[m_index], m_ys[m_index] };
+        return px;
+    }
+    inline CLayoutPixelIterator& operator++() { m_index++; return *this; }
+    inline bool operator!=( const CLayoutPixelIterator& rhs) const { return m_index != rhs.m_index; }
+
+private:
+    const uint8_t* m_xs;
+    const uint8_t* m_ys;
+    uint16_t m_index;
+};
+
+class CLayoutPixelRange {
+public:
+    inline CLayoutPixelRange( const uint8_t* xs, const uint8_t* ys, uint16_t count)
+        : m_xs(xs), m_ys(ys), m_count(count) {}
+    inline CLayoutPixelIterator begin() const { return CLayoutPixelIterator( m_xs, m_ys, 0); }
+    inline CLayoutPixelIterator end() const { return CLayoutPixelIterator( m_xs, m_ys, m_count); }
+
+private:
+    const uint8_t* m_xs;
+    const uint8_t* m_ys;
+    uint16_t m_count;
+};
+
+// Iterates over a list of led indexes; see CLEDLayout::onGridPixels().
+class CLayoutPixelListIterator {
+public:
+    inline CLayoutPixelListIterator( const uint8_t* xs, const uint8_t* ys, const uint16_t* list)
+        : m_xs(xs), m_ys(ys), m_list(list) {}
+
+    inline CLayoutPixel operator*() const
+    {
+        uint16_t i = *m_list;
+        CLayoutPixel px = { i, m_xs[i], m_ys[i] };
+        return px;
+    }
+    inline CLayoutPixelListIterator& operator++() { m_list++; return *this; }
+    inline bool operator!=( const CLayoutPixelListIterator& rhs) const { return m_list != rhs.m_list; }
+
+private:
+    const uint8_t* m_xs;
+    const uint8_t* m_ys;
+    const uint16_t* m_list;
+};
+
+class CLayoutPixelListRange {
+public:
+    inline CLayoutPixelListRange( const uint8_t* xs, const uint8_t* ys, const uint16_t* list, uint16_t count)
+        : m_xs(xs), m_ys(ys), m_list(list), m_count(count) {}
+    inline CLayoutPixelListIterator begin() const { return CLayoutPixelListIterator( m_xs, m_ys, m_list); }
+    inline CLayoutPixelListIterator end() const { return CLayoutPixelListIterator( m_xs, m_ys, m_list + m_count); }
+
+private:
+    const uint8_t* m_xs;
+    const uint8_t* m_ys;
+    const uint16_t* m_list;
+    uint16_t m_count;
+};
+
+// The table builders behind CLEDLayout.  Each fills in the grid table
+// (WIDTH*HEIGHT entries) and the per-led x and y tables (NUM_LEDS
+// entries each).  Segment leds that would land off the grid, or past
+// NUM_LEDS, are left out.
+void layout_build_segments( uint16_t* xy, uint8_t* xs, uint8_t* ys,
+                            uint8_t width, uint8_t height, uint16_t numLeds,
+                            const CLayoutSegment* segments, uint8_t segmentCount);
+void layout_build_matrix( uint16_t* xy, uint8_t* xs, uint8_t* ys,
+                          uint8_t width, uint8_t height, uint16_t numLeds,
+                          TMatrixLayoutType type, const uint16_t* map = NULL);
+
+// Sorts the leds into 'order' (NUM_LEDS entries): those on the grid
+// first, then those off it, each in strip order.  Returns how many
+// are on the grid.
+uint16_t layout_build_order( uint16_t* order, const uint8_t* xs, uint16_t numLeds);
+
+template<uint8_t WIDTH, uint8_t HEIGHT, uint16_t NUM_LEDS>
+class CLEDLayout {
+    uint16_t m_XY[ (uint16_t)WIDTH * HEIGHT];
+    uint8_t  m_X[ NUM_LEDS];
+    uint8_t  m_Y[ NUM_LEDS];
+    uint16_t m_Order[ NUM_LEDS];   // on-grid leds, then off-grid ones
+    uint16_t m_nOnGrid;
+
+public:
+    // A plain row-major matrix until told otherwise.
+    CLEDLayout() { setMatrix( MATRIX_ROW_MAJOR); }
+    CLEDLayout( const CLayoutSegment* segments, uint8_t segmentCount) { setSegments( segments, segmentCount); }
+    CLEDLayout( TMatrixLayoutType type, const uint16_t* map = NULL) { setMatrix( type, map); }
+
+    void setSegments( const CLayoutSegment* segments, uint8_t segmentCount)
+    {
+        layout_build_segments( m_XY, m_X, m_Y, WIDTH, HEIGHT, NUM_LEDS, segments, segmentCount);
+        m_nOnGrid = layout_build_order( m_Order, m_X, NUM_LEDS);
+    }
+
+    // MATRIX_ROW_MAJOR, MATRIX_SERPENTINE, or MATRIX_MAPPED with a
+    // WIDTH*HEIGHT table (RAM or flash) that gets copied in.
+    void setMatrix( TMatrixLayoutType type, const uint16_t* map = NULL)
+    {
+        layout_build_matrix( m_XY, m_X, m_Y, WIDTH, HEIGHT, NUM_LEDS, type, map);
+        m_nOnGrid = layout_build_order( m_Order, m_X, NUM_LEDS);
+    }
+
+    inline uint8_t  width() const { return WIDTH; }
+    inline uint8_t  height() const { return HEIGHT; }
+    inline uint16_t size() const { return NUM_LEDS; }
+
+    // led index of grid cell (x, y); NUM_LEDS if there's no led there
+    inline uint16_t index( uint8_t x, uint8_t y) const { return m_XY[ (uint16_t)y * WIDTH + x]; }
+    inline uint16_t operator()( uint8_t x, uint8_t y) const { return index( x, y); }
+
+    // the WIDTH led indexes of grid row y, left to right
+    inline const uint16_t* row( uint8_t y) const { return m_XY + (uint16_t)y * WIDTH; }
+
+    // where led i sits, or LAYOUT_NOWHERE
+    inline uint8_t x( uint16_t i) const { return m_X[i]; }
+    inline uint8_t y( uint16_t i) const { return m_Y[i]; }
+
+    // every led in strip order, with its position
+    inline CLayoutPixelRange pixels() const { return CLayoutPixelRange( m_X, m_Y, NUM_LEDS); }
+
+    // only the leds that are on the grid, in strip order; an effect
+    // that draws these can skip the position check per led, and clear
+    // the rest with offGridPixels(), which is usually a short list
+    inline CLayoutPixelListRange onGridPixels() const { return CLayoutPixelListRange( m_X, m_Y, m_Order, m_nOnGrid); }
+    // the leds that aren't, in strip order
+    inline CLayoutPixelListRange offGridPixels() const { return CLayoutPixelListRange( m_X, m_Y, m_Order + m_nOnGrid, NUM_LEDS - m_nOnGrid); }
+
+    // this layout as a table-mapped matrix, for blur2d, fill_2dnoise8, etc.
+    inline CMatrixLayout matrix() const { return CMatrixLayout( WIDTH, HEIGHT, MATRIX_MAPPED, m_XY); }
+};
+
+FASTLED_NAMESPACE_END
+
+#endif
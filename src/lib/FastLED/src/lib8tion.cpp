@@ -7,6 +7,79 @@ FASTLED_NAMESPACE_BEGIN
 #define RAND16_SEED  1337
 uint16_t rand16seed = RAND16_SEED;
 
+void CRandomStream::fill8( uint8_t * buf, uint16_t count)
+{
+    for( ; count >= 4; count -= 4) {
+        uint32_t r = random32();
+        *buf++ = r >> 24;
+        *buf++ = r >> 16;
+        *buf++ = r >> 8;
+        *buf++ = r;
+    }
+    if( count) {
+        uint32_t r = random32();
+        for( ; count; count--) {
+            *buf++ = r >> 24;
+            r <<= 8;
+        }
+    }
+}
+
+void CRandomStream::fill16( uint16_t * buf, uint16_t count)
+{
+    for( ; count >= 2; count -= 2) {
+        uint32_t r = random32();
+        *buf++ = r >> 16;
+        *buf++ = r;
+    }
+    if( count) {
+        *buf = random16();
+    }
+}
+
+void CRandomStream::fill32( uint32_t * buf, uint16_t count)
+{
+    for( ; count; count--) {
+        *buf++ = random32();
+    }
+}
+
+
+// sin8_table: round( (sin( i * 2pi / 256) * 127) + 128 ), i = 0..255
+const uint8_t sin8_table[256] = {
+    128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174,
+    177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211, 213, 216,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 239, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 216, 213, 211, 209, 206, 204, 201, 199, 196, 193, 191, 188, 185, 182, 179,
+    177, 174, 171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 140, 137, 134, 131,
+    128, 125, 122, 119, 116, 112, 109, 106, 103, 100,  97,  94,  91,  88,  85,  82,
+     79,  77,  74,  71,  68,  65,  63,  60,  57,  55,  52,  50,  47,  45,  43,  40,
+     38,  36,  34,  32,  30,  28,  26,  24,  22,  21,  19,  17,  16,  15,  13,  12,
+     11,  10,   8,   7,   6,   6,   5,   4,   3,   3,   2,   2,   2,   1,   1,   1,
+      1,   1,   1,   1,   2,   2,   2,   3,   3,   4,   5,   6,   6,   7,   8,  10,
+     11,  12,  13,  15,  16,  17,  19,  21,  22,  24,  26,  28,  30,  32,  34,  36,
+     38,  40,  43,  45,  47,  50,  52,  55,  57,  60,  63,  65,  68,  71,  74,  77,
+     79,  82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 116, 119, 122, 125
+};
+
+// sin16_quarter_table: round( sin( i * pi / 128) * 32767 ), i = 0..64,
+// i.e. one quarter wave in 64 segments, plus a copy of the last
+// entry so that sin16_LUT can always read section+1.
+const int16_t sin16_quarter_table[66] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767, 32767
+};
+
 
 // memset8, memcpy8, memmove8:
 //  optimized avr replacements for the standard "C" library
@@ -126,6 +199,249 @@ void * memmove8 ( void * dst, void* src, uint16_t num )
 
 
 
+// Array forms of scale8, scale8_video, qadd8, qsub8 and avg8.
+//
+//  The generic version treats a 32-bit word as four byte 'lanes'
+//  and is written so that no lane can carry or borrow into its
+//  neighbour:
+//   - scale8 multiplies the even and the odd bytes separately as
+//     two 16-bit lanes each, since 255 * 255 still fits in 16 bits.
+//   - qadd8/qsub8 add the low seven bits of each lane, patch up
+//     bit 7, and turn the carry (or borrow) out of each lane into
+//     a 0xFF (or 0x00) mask.
+//   - avg8 is the usual (a & b) + ((a ^ b) >> 1), with the bits
+//     that would shift across a lane boundary masked off.
+//  Words are moved with memcpy, which gcc turns into a single
+//  (unaligned-capable) LDR/STR on Cortex-M3/M4, so CRGB arrays at
+//  any address are fine.  The tail is finished with the scalar
+//  functions.
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LIB8_ARRAY_SSE2 1
+#elif defined(__ARM_FEATURE_DSP)
+#define LIB8_ARRAY_ARM_DSP 1
+#endif
+
+#if !defined(__AVR__)
+
+#define LANES_LO 0x00FF00FFUL
+#define LANES_7F 0x7F7F7F7FUL
+#define LANES_80 0x80808080UL
+#define LANES_FE 0xFEFEFEFEUL
+
+static inline uint32_t load32( const uint8_t * p)
+{
+    uint32_t w;
+    memcpy( &w, p, 4);
+    return w;
+}
+
+static inline void store32( uint8_t * p, uint32_t w)
+{
+    memcpy( p, &w, 4);
+}
+
+static inline uint32_t scale8_x4( uint32_t w, uint32_t scale)
+{
+    uint32_t even = (((w & LANES_LO) * scale) >> 8) & LANES_LO;
+    uint32_t odd  = (((w >> 8) & LANES_LO) * scale) & ~LANES_LO;
+    return even | odd;
+}
+
+// 0x01 in every lane whose byte is non-zero
+static inline uint32_t nonzero_x4( uint32_t w)
+{
+    return ((((w & LANES_7F) + LANES_7F) | w) & LANES_80) >> 7;
+}
+
+static inline uint32_t qadd8_x4( uint32_t a, uint32_t b)
+{
+#if LIB8_ARRAY_ARM_DSP == 1
+    asm( "uqadd8 %0, %0, %1" : "+r" (a) : "r" (b));
+    return a;
+#else
+    uint32_t sum = ((a & LANES_7F) + (b & LANES_7F)) ^ ((a ^ b) & LANES_80);
+    uint32_t carry = ((a & b) | ((a | b) & ~sum)) & LANES_80;
+    return sum | ((carry >> 7) * 0xFF);
+#endif
+}
+
+static inline uint32_t qsub8_x4( uint32_t a, uint32_t b)
+{
+#if LIB8_ARRAY_ARM_DSP == 1
+    asm( "uqsub8 %0, %0, %1" : "+r" (a) : "r" (b));
+    return a;
+#else
+    uint32_t diff = ((a | LANES_80) - (b & LANES_7F)) ^ ((a ^ ~b) & LANES_80);
+    uint32_t borrow = ((~a & b) | ((~a | b) & diff)) & LANES_80;
+    return diff & ~((borrow >> 7) * 0xFF);
+#endif
+}
+
+static inline uint32_t avg8_x4( uint32_t a, uint32_t b)
+{
+#if LIB8_ARRAY_ARM_DSP == 1
+    asm( "uhadd8 %0, %0, %1" : "+r" (a) : "r" (b));
+    return a;
+#else
+    return (a & b) + (((a ^ b) & LANES_FE) >> 1);
+#endif
+}
+
+#if LIB8_ARRAY_SSE2 == 1
+// scale8 on sixteen bytes: widen to 16-bit lanes, multiply, keep the high byte
+static inline __m128i scale8_x16( __m128i v, __m128i scale16)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( v, zero), scale16), 8);
+    __m128i hi = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( v, zero), scale16), 8);
+    return _mm_packus_epi16( lo, hi);
+}
+#endif
+
+void scale8_array( uint8_t * data, uint32_t count, fract8 scale)
+{
+#if LIB8_ARRAY_SSE2 == 1
+    __m128i scale16 = _mm_set1_epi16( scale);
+    for( ; count >= 16; count -= 16, data += 16) {
+        __m128i v = _mm_loadu_si128( (const __m128i*)data);
+        _mm_storeu_si128( (__m128i*)data, scale8_x16( v, scale16));
+    }
+#endif
+    for( ; count >= 4; count -= 4, data += 4) {
+        store32( data, scale8_x4( load32( data), scale));
+    }
+    for( ; count; count--, data++) {
+        *data = scale8( *data, scale);
+    }
+}
+
+void scale8_video_array( uint8_t * data, uint32_t count, fract8 scale)
+{
+    if( scale == 0) {
+        memset( data, 0, count);
+        return;
+    }
+#if LIB8_ARRAY_SSE2 == 1
+    __m128i scale16 = _mm_set1_epi16( scale);
+    __m128i zero = _mm_setzero_si128();
+    __m128i one = _mm_set1_epi8( 1);
+    for( ; count >= 16; count -= 16, data += 16) {
+        __m128i v = _mm_loadu_si128( (const __m128i*)data);
+        __m128i nz = _mm_andnot_si128( _mm_cmpeq_epi8( v, zero), one);
+        _mm_storeu_si128( (__m128i*)data, _mm_add_epi8( scale8_x16( v, scale16), nz));
+    }
+#endif
+    for( ; count >= 4; count -= 4, data += 4) {
+        uint32_t w = load32( data);
+        store32( data, scale8_x4( w, scale) + nonzero_x4( w));
+    }
+    for( ; count; count--, data++) {
+        *data = scale8_video( *data, scale);
+    }
+}
+
+void qadd8_array( uint8_t * dst, const uint8_t * src, uint32_t count)
+{
+#if LIB8_ARRAY_SSE2 == 1
+    for( ; count >= 16; count -= 16, dst += 16, src += 16) {
+        __m128i a = _mm_loadu_si128( (const __m128i*)dst);
+        __m128i b = _mm_loadu_si128( (const __m128i*)src);
+        _mm_storeu_si128( (__m128i*)dst, _mm_adds_epu8( a, b));
+    }
+#endif
+    for( ; count >= 4; count -= 4, dst += 4, src += 4) {
+        store32( dst, qadd8_x4( load32( dst), load32( src)));
+    }
+    for( ; count; count--, dst++, src++) {
+        *dst = qadd8( *dst, *src);
+    }
+}
+
+void qsub8_array( uint8_t * dst, const uint8_t * src, uint32_t count)
+{
+#if LIB8_ARRAY_SSE2 == 1
+    for( ; count >= 16; count -= 16, dst += 16, src += 16) {
+        __m128i a = _mm_loadu_si128( (const __m128i*)dst);
+        __m128i b = _mm_loadu_si128( (const __m128i*)src);
+        _mm_storeu_si128( (__m128i*)dst, _mm_subs_epu8( a, b));
+    }
+#endif
+    for( ; count >= 4; count -= 4, dst += 4, src += 4) {
+        store32( dst, qsub8_x4( load32( dst), load32( src)));
+    }
+    for( ; count; count--, dst++, src++) {
+        *dst = qsub8( *dst, *src);
+    }
+}
+
+void avg8_array( uint8_t * dst, const uint8_t * src, uint32_t count)
+{
+#if LIB8_ARRAY_SSE2 == 1
+    // _mm_avg_epu8 rounds up; avg8 rounds down, so take back
+    // the half wherever the low bits differ.
+    __m128i one = _mm_set1_epi8( 1);
+    for( ; count >= 16; count -= 16, dst += 16, src += 16) {
+        __m128i a = _mm_loadu_si128( (const __m128i*)dst);
+        __m128i b = _mm_loadu_si128( (const __m128i*)src);
+        __m128i odd = _mm_and_si128( _mm_xor_si128( a, b), one);
+        _mm_storeu_si128( (__m128i*)dst, _mm_sub_epi8( _mm_avg_epu8( a, b), odd));
+    }
+#endif
+    for( ; count >= 4; count -= 4, dst += 4, src += 4) {
+        store32( dst, avg8_x4( load32( dst), load32( src)));
+    }
+    for( ; count; count--, dst++, src++) {
+        *dst = avg8( *dst, *src);
+    }
+}
+
+#else /* AVR */
+
+// AVR has no wide registers to pack lanes into; the scalar asm
+// versions are already as good as it gets.
+
+void scale8_array( uint8_t * data, uint32_t count, fract8 scale)
+{
+    for( ; count; count--, data++) {
+        *data = scale8_LEAVING_R1_DIRTY( *data, scale);
+    }
+    cleanup_R1();
+}
+
+void scale8_video_array( uint8_t * data, uint32_t count, fract8 scale)
+{
+    for( ; count; count--, data++) {
+        *data = scale8_video( *data, scale);
+    }
+}
+
+void qadd8_array( uint8_t * dst, const uint8_t * src, uint32_t count)
+{
+    for( ; count; count--, dst++, src++) {
+        *dst = qadd8( *dst, *src);
+    }
+}
+
+void qsub8_array( uint8_t * dst, const uint8_t * src, uint32_t count)
+{
+    for( ; count; count--, dst++, src++) {
+        *dst = qsub8( *dst, *src);
+    }
+}
+
+void avg8_array( uint8_t * dst, const uint8_t * src, uint32_t count)
+{
+    for( ; count; count--, dst++, src++) {
+        *dst = avg8( *dst, *src);
+    }
+}
+
+#endif /* AVR */
+
+
+
 
 #if 0
 // TEST / VERIFICATION CODE ONLY BELOW THIS POINT
@@ -221,6 +537,49 @@ void testqadd8()
     for(;;){};
 }
 
+// Prints the max error of each sin8/sin16 implementation against
+// float sin(), and the cost of each in micros per 64K calls.
+void testsin()
+{
+    delay(5000);
+    uint8_t e8c = 0, e8lut = 0;
+    for( uint16_t i = 0; i < 256; i++) {
+        int16_t ref = lround( (sin( i * (2 * PI / 256)) * 127) + 128);
+        uint8_t ec = abs( ref - sin8_C( i));
+        uint8_t el = abs( ref - sin8_LUT( i));
+        if( ec > e8c) e8c = ec;
+        if( el > e8lut) e8lut = el;
+    }
+    uint16_t e16c = 0, e16lut = 0;
+    uint16_t i = 0;
+    do {
+        int32_t ref = lround( sin( i * (2 * PI / 65536)) * 32767);
+        uint16_t ec = abs( ref - sin16_C( i));
+        uint16_t el = abs( ref - sin16_LUT( i));
+        if( ec > e16c) e16c = ec;
+        if( el > e16lut) e16lut = el;
+    } while( ++i != 0);
+
+    Serial.print("sin8_C max err: "); Serial.println(e8c);
+    Serial.print("sin8_LUT max err: "); Serial.println(e8lut);
+    Serial.print("sin16_C max err: "); Serial.println(e16c);
+    Serial.print("sin16_LUT max err: "); Serial.println(e16lut);
+
+    volatile uint16_t sink = 0;
+    uint32_t t0;
+    t0 = micros(); i = 0; do { sink += sin8_C( i); } while( ++i != 0);
+    Serial.print("sin8_C us/64K: "); Serial.println( micros() - t0);
+    t0 = micros(); i = 0; do { sink += sin8_LUT( i); } while( ++i != 0);
+    Serial.print("sin8_LUT us/64K: "); Serial.println( micros() - t0);
+    t0 = micros(); i = 0; do { sink += sin16_C( i); } while( ++i != 0);
+    Serial.print("sin16_C us/64K: "); Serial.println( micros() - t0);
+    t0 = micros(); i = 0; do { sink += sin16_LUT( i); } while( ++i != 0);
+    Serial.print("sin16_LUT us/64K: "); Serial.println( micros() - t0);
+
+    Serial.println("done.");
+    for(;;){};
+}
+
 void testnscale8x3()
 {
     delay(5000);
@@ -249,3 +608,110 @@ void testnscale8x3()
 #endif
 
 FASTLED_NAMESPACE_END
+
+
+#ifdef LIB8TION_HOST_CHECK
+// TEST / VERIFICATION CODE ONLY BELOW THIS POINT
+// Host check of CRandomStream: a chi-squared over byte values
+// (expect ~255; fails above 330) and the worst per-bit bias of 16-bit
+// values, for random16 and fill8, plus repeatability, independence of
+// streams and the ranges of the bounded forms.  From this directory:
+//   g++ -std=gnu++11 -O2 -I. -DFASTLED_HOST -DLIB8TION_HOST_CHECK lib8tion.cpp && ./a.out
+#include <stdio.h>
+
+FASTLED_USING_NAMESPACE
+
+static const uint32_t kDraws = 1UL << 20;
+static uint32_t hist[256];
+static uint32_t bits[16];
+
+static void clear_counts()
+{
+    memset( hist, 0, sizeof(hist));
+    memset( bits, 0, sizeof(bits));
+}
+
+static void count( uint16_t r)
+{
+    hist[ r & 0xFF ]++;
+    for( uint8_t b = 0; b < 16; b++) bits[b] += (r >> b) & 1;
+}
+
+// true if the counts look uniform
+static bool report( const char * name, uint32_t n, bool checkBits)
+{
+    double chi = 0;
+    double expect = n / 256.0;
+    for( uint16_t i = 0; i < 256; i++) {
+        chi += (hist[i] - expect) * (hist[i] - expect) / expect;
+    }
+    uint32_t worst = 0;
+    for( uint8_t b = 0; checkBits && b < 16; b++) {
+        uint32_t off = bits[b] > n / 2 ? bits[b] - n / 2 : n / 2 - bits[b];
+        if( off > worst) worst = off;
+    }
+    double bias = worst * 100.0 / n;
+    printf( "%-24s chi2(255) %7.1f  worst bit bias %.3f%%\n", name, chi, bias);
+    return chi < 330 && bias < 0.5;
+}
+
+int main()
+{
+    uint32_t bad = 0;
+
+    CRandomStream rng( 1337, 1);
+    clear_counts();
+    for( uint32_t i = 0; i < kDraws; i++) count( rng.random16());
+    if( !report( "CRandomStream::random16", kDraws, true)) bad++;
+
+    static uint8_t buf8[ 1000];
+    uint32_t n8 = 0;
+    clear_counts();
+    while( n8 < kDraws) {
+        rng.fill8( buf8, sizeof(buf8));
+        for( uint16_t k = 0; k < sizeof(buf8); k++) hist[ buf8[k] ]++;
+        n8 += sizeof(buf8);
+    }
+    if( !report( "CRandomStream::fill8", n8, false)) bad++;
+
+    // the same seed and stream give the same values; another stream
+    // or seed doesn't
+    CRandomStream a( 42, 7), b( 42, 7), c( 42, 8), d( 43, 7);
+    uint32_t same = 0, sameC = 0, sameD = 0;
+    for( uint16_t i = 0; i < 1000; i++) {
+        uint32_t x = a.random32();
+        same  += (x == b.random32());
+        sameC += (x == c.random32());
+        sameD += (x == d.random32());
+    }
+    if( same != 1000 || sameC || sameD) bad++;
+    printf( "repeatable %u/1000, matches with another stream %u, seed %u\n",
+            (unsigned)same, (unsigned)sameC, (unsigned)sameD);
+
+    // fill32 is random32 in a row
+    CRandomStream e( 5, 5), f( 5, 5);
+    uint32_t buf32[ 9];
+    e.fill32( buf32, 9);
+    for( uint8_t i = 0; i < 9; i++) {
+        if( buf32[i] != f.random32()) bad++;
+    }
+
+    // bounded forms stay in range
+    uint32_t out = 0;
+    for( uint32_t i = 0; i < 100000; i++) {
+        uint8_t lim8 = rng.random8() | 1;
+        uint16_t lim16 = rng.random16() | 1;
+        if( rng.random8( lim8) >= lim8) out++;
+        if( rng.random16( lim16) >= lim16) out++;
+        uint8_t r8 = rng.random8( 10, 20);
+        if( r8 < 10 || r8 >= 20) out++;
+        uint16_t r16 = rng.random16( 1000, 3000);
+        if( r16 < 1000 || r16 >= 3000) out++;
+    }
+    if( out) bad++;
+    printf( "out of range: %u\n", (unsigned)out);
+
+    printf( "CRandomStream: %u failed\n", (unsigned)bad);
+    return bad != 0;
+}
+#endif
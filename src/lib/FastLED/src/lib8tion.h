@@ -53,6 +53,14 @@ FASTLED_NAMESPACE_BEGIN
    dimming factor:
      new_bright = scale8_video( orig_bright, dimming);
 
+ - Array forms of the above, which process four
+   bytes at a time where the CPU allows it.
+     scale8_array( data, count, sc)
+     scale8_video_array( data, count, sc)
+     qadd8_array( dst, src, count)
+     qsub8_array( dst, src, count)
+     avg8_array( dst, src, count)
+
 
  - Fast 8- and 16- bit unsigned random numbers.
    Significantly faster than Arduino random(), but
@@ -68,6 +76,10 @@ FASTLED_NAMESPACE_BEGIN
      random16_set_seed( k)    ==  seed = k
      random16_add_entropy( k) ==  seed += k
 
+   CRandomStream offers the same calls on an
+   independent, better-mixed generator, plus
+   fill8/fill16/fill32 for bulk use.
+
 
  - Absolute value of a signed 8-bit value.
      abs8( i)     == abs( i)
@@ -86,14 +98,18 @@ FASTLED_NAMESPACE_BEGIN
    Output is a signed int16_t from -32767 to 32767.
       sin16( x)  == sin( (x/32768.0) * pi) * 32767
       cos16( x)  == cos( (x/32768.0) * pi) * 32767
-   Accurate to more than 99% in all cases.
+   Accurate to more than 99% in all cases; better
+   than 99.98% with the table-driven backend.
 
  - Fast 8-bit approximations of sin and cos.
    Input angle is a uint8_t from 0-255.
    Output is an UNsigned uint8_t from 0 to 255.
        sin8( x)  == (sin( (x/128.0) * pi) * 128) + 128
        cos8( x)  == (cos( (x/128.0) * pi) * 128) + 128
-   Accurate to within about 2%.
+   Accurate to within about 2%; exact to rounding
+   with the table-driven backend.
+   The backend (piecewise-linear or table-driven) is
+   picked at compile time, see FASTLED_TRIG_BACKEND.
 
 
  - Fast 8-bit "easing in/out" function.
@@ -164,6 +180,8 @@ FASTLED_NAMESPACE_BEGIN
    e.g. 120, or Q8.8 fixed-point form.
    BPM88 is beats per minute in ONLY Q8.8 fixed-point 
    form.
+   CBeatBank<N> runs N of these off one clock read
+   per frame.
 
 Lib8tion is pronounced like 'libation': lie-BAY-shun
 
@@ -994,6 +1012,31 @@ uint16_t scale16( uint16_t i, fract16 scale )
 #endif
 
 
+///////////////////////////////////////////////////////////////////////
+//
+// Array forms of the scaling and saturating math primitives.
+// Each one gives exactly the same result per byte as calling the
+// scalar function in a loop, but works on four bytes at a time:
+// packed 'SWAR' math on plain 32-bit ARM (e.g. the Cortex-M3),
+// UQADD8/UQSUB8/UHADD8 where the DSP extension is available
+// (Cortex-M4), and SSE2 on x86 hosts.
+//
+// The arrays need no particular alignment, and an array of CRGB
+// can be passed as ( (uint8_t*)leds, num_leds * 3 ).
+//
+//   scale8_array( data, count, scale)       data[i] = scale8( data[i], scale)
+//   scale8_video_array( data, count, scale) data[i] = scale8_video( data[i], scale)
+//   qadd8_array( dst, src, count)           dst[i]  = qadd8( dst[i], src[i])
+//   qsub8_array( dst, src, count)           dst[i]  = qsub8( dst[i], src[i])
+//   avg8_array( dst, src, count)            dst[i]  = avg8( dst[i], src[i])
+
+void scale8_array( uint8_t * data, uint32_t count, fract8 scale);
+void scale8_video_array( uint8_t * data, uint32_t count, fract8 scale);
+void qadd8_array( uint8_t * dst, const uint8_t * src, uint32_t count);
+void qsub8_array( uint8_t * dst, const uint8_t * src, uint32_t count);
+void avg8_array( uint8_t * dst, const uint8_t * src, uint32_t count);
+
+
 
 // mul8: 8x8 bit multiplication, with 8 bit result
 LIB8STATIC uint8_t mul8( uint8_t i, uint8_t j)
@@ -1236,6 +1279,74 @@ LIB8STATIC void random16_add_entropy( uint16_t entropy)
 }
 
 
+// CRandomStream: an independent, higher-quality PRNG stream.
+//
+//   The shared random8/random16 generator above is a 16-bit LCG,
+//   whose low bits repeat with short periods, and every caller
+//   draws from (and disturbs) the same sequence.  A CRandomStream
+//   is a xorshift32 generator (period 2^32-1) with a multiplicative
+//   output scrambler, in 4 bytes of RAM.  Give each effect its own
+//   stream so that effects don't perturb each other, and so that
+//   an effect can restart its sequence, e.g. once per frame.
+//
+//   The member functions have the same signatures and ranges as
+//   the free random8/random16 functions, so a stream can stand in
+//   for them directly:
+//     CRandomStream rng( seed, streamId);
+//     uint8_t hue = rng.random8();
+//     uint16_t pos = rng.random16( NUM_LEDS);
+//
+//   fill8/fill16/fill32 fill a buffer with many values at once,
+//   using every bit of each 32-bit step.
+class CRandomStream {
+    uint32_t mState;
+
+    // murmur3 finalizer: spreads nearby seeds/stream ids apart
+    static inline uint32_t mix32( uint32_t z)
+    {
+        z = (z ^ (z >> 16)) * 0x85EBCA6BUL;
+        z = (z ^ (z >> 13)) * 0xC2B2AE35UL;
+        return z ^ (z >> 16);
+    }
+
+public:
+    CRandomStream( uint32_t seed = 1337, uint16_t stream = 0) { setSeed( seed, stream); }
+
+    // xorshift32 can't leave (or enter) the all-zeros state
+    inline void setSeed( uint32_t seed, uint16_t stream = 0)
+    {
+        mState = mix32( seed + ((uint32_t)stream * 0x9E3779B9UL));
+        if( mState == 0) mState = 0x9E3779B9UL;
+    }
+
+    inline uint32_t getSeed() const { return mState; }
+
+    inline void addEntropy( uint32_t entropy) { setSeed( mState ^ entropy); }
+
+    inline uint32_t random32()
+    {
+        uint32_t x = mState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        mState = x;
+        return x * 0x9E3779BBUL;
+    }
+
+    inline uint8_t random8() { return random32() >> 24; }
+    inline uint8_t random8( uint8_t lim) { return scale8( random8(), lim); }
+    inline uint8_t random8( uint8_t min, uint8_t lim) { return random8( lim - min) + min; }
+
+    inline uint16_t random16() { return random32() >> 16; }
+    inline uint16_t random16( uint16_t lim) { return ((uint32_t)lim * random16()) >> 16; }
+    inline uint16_t random16( uint16_t min, uint16_t lim) { return random16( lim - min) + min; }
+
+    void fill8( uint8_t * buf, uint16_t count);
+    void fill16( uint16_t * buf, uint16_t count);
+    void fill32( uint32_t * buf, uint16_t count);
+};
+
+
 ///////////////////////////////////////////////////////////////////////
 
 // sin16 & cos16:
@@ -1254,12 +1365,6 @@ LIB8STATIC void random16_add_entropy( uint16_t entropy)
 //        On Arduino/AVR, this approximation is more than
 //        10X faster than floating point sin(x) and cos(x)
 
-#if defined(__AVR__)
-#define sin16 sin16_avr
-#else
-#define sin16 sin16_C
-#endif
-
 LIB8STATIC int16_t sin16_avr( uint16_t theta )
 {
     static const uint8_t data[] =
@@ -1335,11 +1440,6 @@ LIB8STATIC int16_t sin16_C( uint16_t theta )
     return y;
 }
 
-LIB8STATIC int16_t cos16( uint16_t theta)
-{
-    return sin16( theta + 16384);
-}
-
 ///////////////////////////////////////////////////////////////////////
 
 // sin8 & cos8
@@ -1358,13 +1458,6 @@ LIB8STATIC int16_t cos16( uint16_t theta)
 //        On Arduino/AVR, this approximation is more than
 //        20X faster than floating point sin(x) and cos(x)
 
-#if defined(__AVR__) && !defined(LIB8_ATTINY)
-#define sin8 sin8_avr
-#else
-#define sin8 sin8_C
-#endif
-
-
 const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
 
 LIB8STATIC uint8_t  sin8_avr( uint8_t theta)
@@ -1448,11 +1541,125 @@ LIB8STATIC uint8_t sin8_C( uint8_t theta)
 }
 
 
+///////////////////////////////////////////////////////////////////////
+
+// sin8_LUT & sin16_LUT
+//        Table-driven sin(x) for platforms where a flash read is
+//        cheaper than the piecewise-linear math above, i.e. ARM.
+//
+//        sin8_LUT is a straight lookup into a full-resolution
+//        256-entry table of round( (sin( x ) * 127) + 128 ), so
+//        it has the same 1..255 range as sin8_C but no error
+//        beyond rounding.  sin8_C is off by up to 3 from the
+//        same reference.
+//
+//        sin16_LUT interpolates linearly within a 64-segment
+//        quarter-wave table and mirrors it into the other three
+//        quadrants.  Max error is 4 (0.012%) against
+//          float s = sin( x ) * 32767.0;
+//        versus 226 (0.69%) for sin16_C.
+
+extern const uint8_t sin8_table[256];
+extern const int16_t sin16_quarter_table[66];
+
+LIB8STATIC uint8_t sin8_LUT( uint8_t theta)
+{
+    return sin8_table[theta];
+}
+
+LIB8STATIC int16_t sin16_LUT( uint16_t theta)
+{
+    uint16_t offset = theta & 0x3FFF; // 0..16383
+    // mirror the 2nd and 4th quadrants; this yields 1..16384, and
+    // the table carries one padding entry so that 16384 can still
+    // read its 'next' point.
+    if( theta & 0x4000 ) offset = 0x4000 - offset;
+
+    uint8_t section = offset >> 8;   // 0..64
+    uint8_t frac    = offset & 0xFF;
+
+    int16_t a = sin16_quarter_table[ section ];
+    int16_t b = sin16_quarter_table[ section + 1 ];
+    int16_t y = a + (((int32_t)(b - a) * frac) >> 8);
+
+    if( theta & 0x8000 ) y = -y;
+
+    return y;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+
+// Trig backends
+//        sin8, sin16, cos8 and cos16 dispatch to a backend policy
+//        class chosen at compile time.  A backend is any class
+//        with these two static members:
+//          static uint8_t sin8( uint8_t theta);
+//          static int16_t sin16( uint16_t theta);
+//
+//        CTrigApprox  - piecewise-linear sin8_C/sin16_C,
+//                       or sin8_avr/sin16_avr on AVR
+//        CTrigTable   - sin8_LUT/sin16_LUT
+//
+//        The default is CTrigApprox on AVR and CTrigTable
+//        everywhere else.  To override it, #define
+//        FASTLED_TRIG_BACKEND before including FastLED.h, e.g.
+//          #define FASTLED_TRIG_BACKEND CTrigApprox
+//        Backends can also be called directly for a one-off,
+//        e.g. CTrigApprox::sin8( x).
+
+struct CTrigApprox {
+    static inline uint8_t sin8( uint8_t theta)
+    {
+#if defined(__AVR__) && !defined(LIB8_ATTINY)
+        return sin8_avr( theta);
+#else
+        return sin8_C( theta);
+#endif
+    }
+    static inline int16_t sin16( uint16_t theta)
+    {
+#if defined(__AVR__)
+        return sin16_avr( theta);
+#else
+        return sin16_C( theta);
+#endif
+    }
+};
+
+struct CTrigTable {
+    static inline uint8_t sin8( uint8_t theta) { return sin8_LUT( theta); }
+    static inline int16_t sin16( uint16_t theta) { return sin16_LUT( theta); }
+};
+
+#if !defined(FASTLED_TRIG_BACKEND)
+#if defined(__AVR__)
+#define FASTLED_TRIG_BACKEND CTrigApprox
+#else
+#define FASTLED_TRIG_BACKEND CTrigTable
+#endif
+#endif
+
+LIB8STATIC uint8_t sin8( uint8_t theta)
+{
+    return FASTLED_TRIG_BACKEND::sin8( theta);
+}
+
 LIB8STATIC uint8_t cos8( uint8_t theta)
 {
     return sin8( theta + 64);
 }
 
+LIB8STATIC int16_t sin16( uint16_t theta)
+{
+    return FASTLED_TRIG_BACKEND::sin16( theta);
+}
+
+LIB8STATIC int16_t cos16( uint16_t theta)
+{
+    return sin16( theta + 16384);
+}
+
 
 ///////////////////////////////////////////////////////////////////////
 //
@@ -1898,7 +2105,7 @@ typedef q<uint16_t, 12,4> q124;
 // that provides similar functionality.
 // You can also force use of the get_millisecond_timer function
 // by #defining USE_GET_MILLISECOND_TIMER.
-#if (defined(ARDUINO) || defined(SPARK)) && !defined(USE_GET_MILLISECOND_TIMER)
+#if (defined(ARDUINO) || defined(SPARK) || defined(FASTLED_HOST)) && !defined(USE_GET_MILLISECOND_TIMER)
 // Forward declaration of Arduino function 'millis'.
 // uint32_t millis();
 #define GET_MILLIS ::millis
@@ -1983,6 +2190,104 @@ LIB8STATIC uint8_t beatsin8( accum88 beats_per_minute, uint8_t lowest = 0, uint8
 }
 
 
+// CBeatBank<N>: a bank of N beat generators that share one clock read.
+//
+//   Each beat16/beatsin16/... call above reads the millisecond clock
+//   and redoes the BPM multiply.  A pattern that drives several
+//   oscillators per frame can instead set up a bank once, call
+//   update() once per frame, which samples the clock a single time
+//   and advances every oscillator's 32-bit phase accumulator by
+//   (elapsed ms * BPM step), and then read as many values as it
+//   likes at no further cost.
+//
+//   Values are bit-for-bit the same as the free functions would
+//   have returned at the moment update() sampled the clock (with
+//   timebase 0), since the accumulator wraps exactly the way
+//   beat88's 32-bit product does.
+//
+//   Example (the 'juggle' pattern):
+//     static CBeatBank<8> dots;
+//     for( uint8_t i = 0; i < 8; i++) dots.set( i, i + 7, 0, NUM_LEDS);
+//     ...
+//     uint16_t pos[8];
+//     dots.beatsin16_all( pos);        // update() + all eight values
+//
+//   set() takes BPM like beatsin16 (simple 1-255, or Q8.8), set88()
+//   takes Q8.8 only, like beatsin88.  For 8-bit oscillators, use
+//   set() with 8-bit low/high/phase and read them with beatsin8(i).
+template<uint8_t N> class CBeatBank {
+    uint32_t mAccum[N];
+    uint32_t mStep[N];
+    uint16_t mLowest[N];
+    uint16_t mHighest[N];
+    uint16_t mPhase[N];
+    uint32_t mLastMillis;
+
+public:
+    CBeatBank() : mLastMillis( 0)
+    {
+        for( uint8_t i = 0; i < N; i++) set88( i, 0);
+    }
+
+    void set88( uint8_t i, accum88 beats_per_minute_88, uint16_t lowest = 0,
+                uint16_t highest = 65535, uint16_t phase_offset = 0)
+    {
+        // 280/65536 per ms: see beat88
+        mStep[i] = (uint32_t)beats_per_minute_88 * 280;
+        mAccum[i] = mLastMillis * mStep[i];
+        mLowest[i] = lowest;
+        mHighest[i] = highest;
+        mPhase[i] = phase_offset;
+    }
+
+    void set( uint8_t i, accum88 beats_per_minute, uint16_t lowest = 0,
+              uint16_t highest = 65535, uint16_t phase_offset = 0)
+    {
+        if( beats_per_minute < 256) beats_per_minute <<= 8;
+        set88( i, beats_per_minute, lowest, highest, phase_offset);
+    }
+
+    // Sample the clock once and advance every oscillator.
+    void update()
+    {
+        uint32_t now = GET_MILLIS();
+        uint32_t elapsed = now - mLastMillis;
+        mLastMillis = now;
+        for( uint8_t i = 0; i < N; i++) {
+            mAccum[i] += elapsed * mStep[i];
+        }
+    }
+
+    // sawtooth outputs, like beat16/beat88 and beat8
+    inline uint16_t beat16( uint8_t i) const { return mAccum[i] >> 16; }
+    inline uint8_t beat8( uint8_t i) const { return mAccum[i] >> 24; }
+
+    // sine outputs, like beatsin16/beatsin88 and beatsin8
+    inline uint16_t beatsin16( uint8_t i) const
+    {
+        uint16_t beatsin = (sin16( beat16( i) + mPhase[i]) + 32768);
+        uint16_t rangewidth = mHighest[i] - mLowest[i];
+        return mLowest[i] + scale16( beatsin, rangewidth);
+    }
+
+    inline uint8_t beatsin8( uint8_t i) const
+    {
+        uint8_t beatsin = sin8( beat8( i) + (uint8_t)mPhase[i]);
+        uint8_t rangewidth = (uint8_t)mHighest[i] - (uint8_t)mLowest[i];
+        return (uint8_t)mLowest[i] + scale8( beatsin, rangewidth);
+    }
+
+    // update(), then every oscillator's beatsin16 value into out[0..N-1]
+    void beatsin16_all( uint16_t * out)
+    {
+        update();
+        for( uint8_t i = 0; i < N; i++) {
+            out[i] = beatsin16( i);
+        }
+    }
+};
+
+
 // seconds16, minutes16, hours8
 //   functions to return the current seconds, minutes, or hours
 //   since boot time, in the specified width.  Used as part of
@@ -305,11 +305,31 @@ int16_t inoise16_raw(uint32_t x, uint32_t y, uint32_t z)
   return ans;
 }
 
-uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z) {
-  int32_t ans = inoise16_raw(x,y,z);
+// Scale raw noise to the full output range of each inoise function.
+static uint16_t inline __attribute__((always_inline)) noise16_scale3d(int16_t raw) {
+  int32_t ans = raw;
   ans = ans + 19052L;
   uint32_t pan = ans;
   return (pan*220L)>>7;
+}
+
+static uint16_t inline __attribute__((always_inline)) noise16_scale2d(int16_t raw) {
+  int32_t ans = raw;
+  ans = ans + 17308L;
+  uint32_t pan = ans;
+  return (pan*242L)>>7;
+}
+
+static uint8_t inline __attribute__((always_inline)) noise8_scale3d(int8_t raw) {
+  return scale8(76+(raw),215)<<1;
+}
+
+static uint8_t inline __attribute__((always_inline)) noise8_scale2d(int8_t raw) {
+  return scale8(69+raw,237)<<1;
+}
+
+uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z) {
+  return noise16_scale3d(inoise16_raw(x,y,z));
   // // return scale16by8(pan,220)<<1;
   // return ((inoise16_raw(x,y,z)+19052)*220)>>7;
   // return scale16by8(inoise16_raw(x,y,z)+19052,220)<<1;
@@ -349,10 +369,7 @@ int16_t inoise16_raw(uint32_t x, uint32_t y)
 }
 
 uint16_t inoise16(uint32_t x, uint32_t y) {
-  int32_t ans = inoise16_raw(x,y);
-  ans = ans + 17308L;
-  uint32_t pan = ans;
-  return (pan*242L)>>7;
+  return noise16_scale2d(inoise16_raw(x,y));
   // return (uint32_t)(((int32_t)inoise16_raw(x,y)+(uint32_t)17308)*242)>>7;
   // return scale16by8(inoise16_raw(x,y)+17308,242)<<1;
 }
@@ -429,7 +446,7 @@ int8_t inoise8_raw(uint16_t x, uint16_t y, uint16_t z)
 }
 
 uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z) {
-  return scale8(76+(inoise8_raw(x,y,z)),215)<<1;
+  return noise8_scale3d(inoise8_raw(x,y,z));
 }
 
 int8_t inoise8_raw(uint16_t x, uint16_t y)
@@ -468,7 +485,7 @@ int8_t inoise8_raw(uint16_t x, uint16_t y)
 }
 
 uint8_t inoise8(uint16_t x, uint16_t y) {
-  return scale8(69+inoise8_raw(x,y),237)<<1;
+  return noise8_scale2d(inoise8_raw(x,y));
 }
 
 int8_t inoise8_raw(uint16_t x)
@@ -501,6 +518,493 @@ uint8_t inoise8(uint16_t x) {
   return scale8(69+inoise8_raw(x), 255)<<1;
 }
 
+// Noise is worked out in runs of this many points, so that the fills
+// need only small fixed buffers on the stack.
+#define NOISE_RUN 16
+
+// Multi-lane inoise16 kernel.
+//
+// inoise16_raw_lanes works out FASTLED_NOISE_LANES neighbouring points of
+// a scanline at once: the corner hashes are gathered per point (and per
+// lattice cell, as in the scalar kernels below), then the gradients and
+// the three levels of interpolation run on all lanes together.  Each step
+// is the lane-wise form of grad16 / FADE / LERP, so the results are the
+// same, bit for bit, as inoise16_raw:
+//   - grad16's (u+v)>>1 is the floor average (u>>1) + (v>>1) + (u&v&1),
+//     which can't overflow a 16-bit lane;
+//   - FADE and scale16 are the high half of a 16x16 unsigned multiply;
+//   - lerp15by16 picks |b-a| and the add or subtract with a b>a mask.
+//
+// The lane operations come from one of these:
+//   CNoiseLanesAVX2   16 lanes, x86 hosts built with AVX2
+//   CNoiseLanesSSE2    8 lanes, x86 hosts
+//   CNoiseLanesPacked  2 lanes packed in a 32-bit word, using
+//                      SADD16/SSUB16/SHADD16/SEL on Cortex-M4 (DSP
+//                      extension), or plain C elsewhere
+// Cortex-M3 (the Photon) has no packed halfword math, so by default it
+// keeps the scalar kernels.  Build with -DFASTLED_NOISE_LANES=1 to force
+// the scalar code, or =2 to force the packed lanes.
+
+#if !defined(FASTLED_NOISE_LANES)
+#if defined(__AVX2__)
+#define FASTLED_NOISE_LANES 16
+#elif defined(__SSE2__)
+#define FASTLED_NOISE_LANES 8
+#elif defined(__ARM_FEATURE_DSP)
+#define FASTLED_NOISE_LANES 2
+#else
+#define FASTLED_NOISE_LANES 1
+#endif
+#endif
+
+#if FASTLED_NOISE_LANES == 16
+#if !defined(__AVX2__)
+#error "FASTLED_NOISE_LANES 16 needs AVX2"
+#endif
+#include <immintrin.h>
+
+struct CNoiseLanesAVX2 {
+  enum { LANES = 16 };
+  typedef __m256i V;
+  static V set1(uint16_t a) { return _mm256_set1_epi16(a); }
+  static V load(const uint16_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+  static void store(int16_t *p, V a) { _mm256_storeu_si256((__m256i*)p, a); }
+  static V add(V a, V b) { return _mm256_add_epi16(a, b); }
+  static V sub(V a, V b) { return _mm256_sub_epi16(a, b); }
+  static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+  static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+  static V xor_(V a, V b) { return _mm256_xor_si256(a, b); }
+  static V cmpgt(V a, V b) { return _mm256_cmpgt_epi16(a, b); }
+  static V cmpeq(V a, V b) { return _mm256_cmpeq_epi16(a, b); }
+  static V mulhi(V a, V b) { return _mm256_mulhi_epu16(a, b); }
+  static V half(V a) { return _mm256_srli_epi16(a, 1); }
+  static V avg(V a, V b) {
+    return add(add(_mm256_srai_epi16(a, 1), _mm256_srai_epi16(b, 1)), and_(and_(a, b), set1(1)));
+  }
+  static V select(V m, V a, V b) { return _mm256_or_si256(_mm256_and_si256(m, a), _mm256_andnot_si256(m, b)); }
+};
+typedef CNoiseLanesAVX2 CNoiseLanes;
+
+#elif FASTLED_NOISE_LANES == 8
+#if !defined(__SSE2__)
+#error "FASTLED_NOISE_LANES 8 needs SSE2"
+#endif
+#include <emmintrin.h>
+
+struct CNoiseLanesSSE2 {
+  enum { LANES = 8 };
+  typedef __m128i V;
+  static V set1(uint16_t a) { return _mm_set1_epi16(a); }
+  static V load(const uint16_t *p) { return _mm_loadu_si128((const __m128i*)p); }
+  static void store(int16_t *p, V a) { _mm_storeu_si128((__m128i*)p, a); }
+  static V add(V a, V b) { return _mm_add_epi16(a, b); }
+  static V sub(V a, V b) { return _mm_sub_epi16(a, b); }
+  static V and_(V a, V b) { return _mm_and_si128(a, b); }
+  static V or_(V a, V b) { return _mm_or_si128(a, b); }
+  static V xor_(V a, V b) { return _mm_xor_si128(a, b); }
+  static V cmpgt(V a, V b) { return _mm_cmpgt_epi16(a, b); }
+  static V cmpeq(V a, V b) { return _mm_cmpeq_epi16(a, b); }
+  static V mulhi(V a, V b) { return _mm_mulhi_epu16(a, b); }
+  static V half(V a) { return _mm_srli_epi16(a, 1); }
+  static V avg(V a, V b) {
+    return add(add(_mm_srai_epi16(a, 1), _mm_srai_epi16(b, 1)), and_(and_(a, b), set1(1)));
+  }
+  static V select(V m, V a, V b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+};
+typedef CNoiseLanesSSE2 CNoiseLanes;
+
+#elif FASTLED_NOISE_LANES == 2
+
+struct CNoiseLanesPacked {
+  enum { LANES = 2 };
+  typedef uint32_t V;
+  static V set1(uint16_t a) { return (uint32_t)a * 0x00010001UL; }
+  static V load(const uint16_t *p) { return p[0] | ((uint32_t)p[1] << 16); }
+  static void store(int16_t *p, V a) { p[0] = a; p[1] = a >> 16; }
+  static V and_(V a, V b) { return a & b; }
+  static V or_(V a, V b) { return a | b; }
+  static V xor_(V a, V b) { return a ^ b; }
+  static V select(V m, V a, V b) { return (m & a) | (~m & b); }
+  static V half(V a) { return (a >> 1) & 0x7FFF7FFFUL; }
+  static V mulhi(V a, V b) {
+    return ((((a & 0xFFFF) * (b & 0xFFFF)) >> 16) | (((a >> 16) * (b >> 16)) & 0xFFFF0000UL));
+  }
+#if defined(__ARM_FEATURE_DSP)
+  static V add(V a, V b) { asm("sadd16 %0, %0, %1" : "+r" (a) : "r" (b)); return a; }
+  static V sub(V a, V b) { asm("ssub16 %0, %0, %1" : "+r" (a) : "r" (b)); return a; }
+  static V avg(V a, V b) { asm("shadd16 %0, %0, %1" : "+r" (a) : "r" (b)); return a; }
+  // ssub16 sets a GE flag per lane for b >= a; sel then takes 0 there
+  static V cmpgt(V a, V b) {
+    V m;
+    asm("ssub16 %0, %1, %2\n\tsel %0, %3, %4" : "=&r" (m) : "r" (b), "r" (a), "r" (0UL), "r" (~0UL) : "cc");
+    return m;
+  }
+#else
+  static V add(V a, V b) { return ((a + b) & 0xFFFF) | ((a & 0xFFFF0000UL) + (b & 0xFFFF0000UL)); }
+  static V sub(V a, V b) { return ((a - b) & 0xFFFF) | ((a & 0xFFFF0000UL) - (b & 0xFFFF0000UL)); }
+  static V avg(V a, V b) {
+    return set2(((int16_t)a + (int16_t)b) >> 1, ((int16_t)(a >> 16) + (int16_t)(b >> 16)) >> 1);
+  }
+  static V cmpgt(V a, V b) {
+    return set2((int16_t)a > (int16_t)b ? 0xFFFF : 0, (int16_t)(a >> 16) > (int16_t)(b >> 16) ? 0xFFFF : 0);
+  }
+  static V set2(uint16_t lo, uint16_t hi) { return lo | ((uint32_t)hi << 16); }
+#endif
+  static V cmpeq(V a, V b) { return ~(cmpgt(a, b) | cmpgt(b, a)); }
+};
+typedef CNoiseLanesPacked CNoiseLanes;
+
+#elif FASTLED_NOISE_LANES != 1
+#error "FASTLED_NOISE_LANES must be 1, 2, 8 or 16"
+#endif
+
+#if FASTLED_NOISE_LANES > 1
+
+template<class T>
+static inline __attribute__((always_inline)) typename T::V grad16_lanes(typename T::V hash, typename T::V x, typename T::V y, typename T::V z) {
+  typedef typename T::V V;
+  // hash already masked to 0..15
+  V u = T::select(T::cmpgt(T::set1(8), hash), x, y);
+  V v = T::select(T::cmpgt(T::set1(4), hash), y,
+                  T::select(T::cmpeq(T::or_(hash, T::set1(2)), T::set1(14)), x, z));
+  V n1 = T::cmpeq(T::and_(hash, T::set1(1)), T::set1(1));
+  V n2 = T::cmpeq(T::and_(hash, T::set1(2)), T::set1(2));
+  u = T::sub(T::xor_(u, n1), n1);
+  v = T::sub(T::xor_(v, n2), n2);
+  return T::avg(u, v);
+}
+
+template<class T>
+static inline __attribute__((always_inline)) typename T::V grad16_lanes(typename T::V hash, typename T::V x, typename T::V y) {
+  typedef typename T::V V;
+  // hash already masked to 0..7
+  V m = T::cmpgt(T::set1(4), hash);
+  V u = T::select(m, x, y);
+  V v = T::select(m, y, x);
+  V n1 = T::cmpeq(T::and_(hash, T::set1(1)), T::set1(1));
+  V n2 = T::cmpeq(T::and_(hash, T::set1(2)), T::set1(2));
+  u = T::sub(T::xor_(u, n1), n1);
+  v = T::sub(T::xor_(v, n2), n2);
+  return T::avg(u, v);
+}
+
+template<class T>
+static inline __attribute__((always_inline)) typename T::V lerp15by16_lanes(typename T::V a, typename T::V b, typename T::V frac) {
+  typedef typename T::V V;
+  V gt = T::cmpgt(b, a);
+  V scaled = T::mulhi(T::select(gt, T::sub(b, a), T::sub(a, b)), frac);
+  return T::select(gt, T::add(a, scaled), T::sub(a, scaled));
+}
+
+template<class T>
+static void inoise16_raw_lanes(int16_t *pOut, uint16_t count, uint32_t x, uint32_t dx, uint32_t y, uint32_t z)
+{
+  typedef typename T::V V;
+  uint8_t Y = (y>>16)&0xFF;
+  uint8_t Z = (z>>16)&0xFF;
+  uint16_t v = y & 0xFFFF;
+  uint16_t w = z & 0xFFFF;
+  int16_t yy = (v >> 1) & 0x7FFF;
+  int16_t zz = (w >> 1) & 0x7FFF;
+  const V N = T::set1(0x8000);
+  const V YY = T::set1(yy), YN = T::xor_(YY, N);
+  const V ZZ = T::set1(zz), ZN = T::xor_(ZZ, N);
+  const V FV = T::set1(FADE(v)), FW = T::set1(FADE(w));
+
+  uint16_t lastX = 0x100;
+  uint8_t h[8] = { 0 };
+  uint16_t U[T::LANES];
+  uint16_t H[8][T::LANES];
+  while(count) {
+    for(uint8_t k = 0; k < T::LANES; k++, x += dx) {
+      uint8_t X = (x>>16)&0xFF;
+      if(X != lastX) {
+        lastX = X;
+        uint8_t A = P(X)+Y;
+        uint8_t AA = P(A)+Z;
+        uint8_t AB = P(A+1)+Z;
+        uint8_t B = P(X+1)+Y;
+        uint8_t BA = P(B) + Z;
+        uint8_t BB = P(B+1)+Z;
+        h[0] = P(AA); h[1] = P(BA); h[2] = P(AB); h[3] = P(BB);
+        h[4] = P(AA+1); h[5] = P(BA+1); h[6] = P(AB+1); h[7] = P(BB+1);
+      }
+      U[k] = x;
+      for(uint8_t c = 0; c < 8; c++) { H[c][k] = h[c] & 15; }
+    }
+
+    V u = T::load(U);
+    V xx = T::half(u);
+    V xn = T::xor_(xx, N);
+    u = T::mulhi(u, u);
+
+    V X1 = lerp15by16_lanes<T>(grad16_lanes<T>(T::load(H[0]), xx, YY, ZZ), grad16_lanes<T>(T::load(H[1]), xn, YY, ZZ), u);
+    V X2 = lerp15by16_lanes<T>(grad16_lanes<T>(T::load(H[2]), xx, YN, ZZ), grad16_lanes<T>(T::load(H[3]), xn, YN, ZZ), u);
+    V X3 = lerp15by16_lanes<T>(grad16_lanes<T>(T::load(H[4]), xx, YY, ZN), grad16_lanes<T>(T::load(H[5]), xn, YY, ZN), u);
+    V X4 = lerp15by16_lanes<T>(grad16_lanes<T>(T::load(H[6]), xx, YN, ZN), grad16_lanes<T>(T::load(H[7]), xn, YN, ZN), u);
+
+    V Y1 = lerp15by16_lanes<T>(X1, X2, FV);
+    V Y2 = lerp15by16_lanes<T>(X3, X4, FV);
+    V ans = lerp15by16_lanes<T>(Y1, Y2, FW);
+
+    if(count >= T::LANES) {
+      T::store(pOut, ans);
+      pOut += T::LANES;
+      count -= T::LANES;
+    } else {
+      int16_t tail[T::LANES];
+      T::store(tail, ans);
+      memcpy(pOut, tail, count * sizeof(int16_t));
+      count = 0;
+    }
+  }
+}
+
+template<class T>
+static void inoise16_raw_lanes(int16_t *pOut, uint16_t count, uint32_t x, uint32_t dx, uint32_t y)
+{
+  typedef typename T::V V;
+  uint8_t Y = y>>16;
+  uint16_t v = y & 0xFFFF;
+  int16_t yy = (v >> 1) & 0x7FFF;
+  const V N = T::set1(0x8000);
+  const V YY = T::set1(yy), YN = T::xor_(YY, N);
+  const V FV = T::set1(FADE(v));
+
+  uint16_t lastX = 0x100;
+  uint8_t h[4] = { 0 };
+  uint16_t U[T::LANES];
+  uint16_t H[4][T::LANES];
+  while(count) {
+    for(uint8_t k = 0; k < T::LANES; k++, x += dx) {
+      uint8_t X = x>>16;
+      if(X != lastX) {
+        lastX = X;
+        uint8_t A = P(X)+Y;
+        uint8_t B = P(X+1)+Y;
+        h[0] = P(P(A)); h[1] = P(P(B)); h[2] = P(P(A+1)); h[3] = P(P(B+1));
+      }
+      U[k] = x;
+      for(uint8_t c = 0; c < 4; c++) { H[c][k] = h[c] & 7; }
+    }
+
+    V u = T::load(U);
+    V xx = T::half(u);
+    V xn = T::xor_(xx, N);
+    u = T::mulhi(u, u);
+
+    V X1 = lerp15by16_lanes<T>(grad16_lanes<T>(T::load(H[0]), xx, YY), grad16_lanes<T>(T::load(H[1]), xn, YY), u);
+    V X2 = lerp15by16_lanes<T>(grad16_lanes<T>(T::load(H[2]), xx, YN), grad16_lanes<T>(T::load(H[3]), xn, YN), u);
+    V ans = lerp15by16_lanes<T>(X1, X2, FV);
+
+    if(count >= T::LANES) {
+      T::store(pOut, ans);
+      pOut += T::LANES;
+      count -= T::LANES;
+    } else {
+      int16_t tail[T::LANES];
+      T::store(tail, ans);
+      memcpy(pOut, tail, count * sizeof(int16_t));
+      count = 0;
+    }
+  }
+}
+
+#endif
+
+// Scanline noise kernels.
+//
+// Each of these produces exactly what the matching inoise function would
+// for count points starting at x and stepping by dx, with the other
+// coordinates fixed.  The terms that only depend on the fixed coordinates
+// are worked out once per run, and the corner hashes of a lattice cell are
+// worked out once per cell rather than once per point; neighboring points
+// usually share a cell.  sink(i, raw) receives each raw noise value.
+
+template<class SINK>
+static void inoise16_raw_run(uint32_t x, uint32_t dx, uint16_t count, uint32_t y, uint32_t z, SINK sink)
+{
+#if FASTLED_NOISE_LANES > 1
+  int16_t raw[NOISE_RUN];
+  for(uint16_t i = 0; i < count; i += NOISE_RUN, x += NOISE_RUN * dx) {
+    uint16_t n = (count - i < NOISE_RUN) ? (count - i) : NOISE_RUN;
+    inoise16_raw_lanes<CNoiseLanes>(raw, n, x, dx, y, z);
+    for(uint16_t k = 0; k < n; k++) { sink(i + k, raw[k]); }
+  }
+#else
+  uint8_t Y = (y>>16)&0xFF;
+  uint8_t Z = (z>>16)&0xFF;
+  uint16_t v = y & 0xFFFF;
+  uint16_t w = z & 0xFFFF;
+  int16_t yy = (v >> 1) & 0x7FFF;
+  int16_t zz = (w >> 1) & 0x7FFF;
+  uint16_t N = 0x8000L;
+  v = FADE(v); w = FADE(w);
+
+  uint16_t lastX = 0x100;
+  uint8_t h0 = 0, h1 = 0, h2 = 0, h3 = 0, h4 = 0, h5 = 0, h6 = 0, h7 = 0;
+  for(uint16_t i = 0; i < count; i++, x += dx) {
+    uint8_t X = (x>>16)&0xFF;
+    if(X != lastX) {
+      lastX = X;
+      uint8_t A = P(X)+Y;
+      uint8_t AA = P(A)+Z;
+      uint8_t AB = P(A+1)+Z;
+      uint8_t B = P(X+1)+Y;
+      uint8_t BA = P(B) + Z;
+      uint8_t BB = P(B+1)+Z;
+      h0 = P(AA); h1 = P(BA); h2 = P(AB); h3 = P(BB);
+      h4 = P(AA+1); h5 = P(BA+1); h6 = P(AB+1); h7 = P(BB+1);
+    }
+
+    uint16_t u = x & 0xFFFF;
+    int16_t xx = (u >> 1) & 0x7FFF;
+    u = FADE(u);
+
+    int16_t X1 = LERP(grad16(h0, xx, yy, zz), grad16(h1, xx - N, yy, zz), u);
+    int16_t X2 = LERP(grad16(h2, xx, yy-N, zz), grad16(h3, xx - N, yy - N, zz), u);
+    int16_t X3 = LERP(grad16(h4, xx, yy, zz-N), grad16(h5, xx - N, yy, zz-N), u);
+    int16_t X4 = LERP(grad16(h6, xx, yy-N, zz-N), grad16(h7, xx - N, yy - N, zz - N), u);
+
+    int16_t Y1 = LERP(X1,X2,v);
+    int16_t Y2 = LERP(X3,X4,v);
+
+    sink(i, (int16_t)LERP(Y1,Y2,w));
+  }
+#endif
+}
+
+template<class SINK>
+static void inoise16_raw_run(uint32_t x, uint32_t dx, uint16_t count, uint32_t y, SINK sink)
+{
+#if FASTLED_NOISE_LANES > 1
+  int16_t raw[NOISE_RUN];
+  for(uint16_t i = 0; i < count; i += NOISE_RUN, x += NOISE_RUN * dx) {
+    uint16_t n = (count - i < NOISE_RUN) ? (count - i) : NOISE_RUN;
+    inoise16_raw_lanes<CNoiseLanes>(raw, n, x, dx, y);
+    for(uint16_t k = 0; k < n; k++) { sink(i + k, raw[k]); }
+  }
+#else
+  uint8_t Y = y>>16;
+  uint16_t v = y & 0xFFFF;
+  int16_t yy = (v >> 1) & 0x7FFF;
+  uint16_t N = 0x8000L;
+  v = FADE(v);
+
+  uint16_t lastX = 0x100;
+  uint8_t h0 = 0, h1 = 0, h2 = 0, h3 = 0;
+  for(uint16_t i = 0; i < count; i++, x += dx) {
+    uint8_t X = x>>16;
+    if(X != lastX) {
+      lastX = X;
+      uint8_t A = P(X)+Y;
+      uint8_t B = P(X+1)+Y;
+      h0 = P(P(A)); h1 = P(P(B)); h2 = P(P(A+1)); h3 = P(P(B+1));
+    }
+
+    uint16_t u = x & 0xFFFF;
+    int16_t xx = (u >> 1) & 0x7FFF;
+    u = FADE(u);
+
+    int16_t X1 = LERP(grad16(h0, xx, yy), grad16(h1, xx - N, yy), u);
+    int16_t X2 = LERP(grad16(h2, xx, yy-N), grad16(h3, xx - N, yy - N), u);
+
+    sink(i, (int16_t)LERP(X1,X2,v));
+  }
+#endif
+}
+
+template<class SINK>
+static void inoise8_raw_run(uint16_t x, uint16_t dx, uint16_t count, uint16_t y, uint16_t z, SINK sink)
+{
+  uint8_t Y = y>>8;
+  uint8_t Z = z>>8;
+  uint8_t v = y;
+  uint8_t w = z;
+  int8_t yy = ((uint8_t)(y)>>1) & 0x7F;
+  int8_t zz = ((uint8_t)(z)>>1) & 0x7F;
+  uint8_t N = 0x80;
+  v = scale8(v,v); w = scale8(w,w);
+
+  uint16_t lastX = 0x100;
+  uint8_t h0 = 0, h1 = 0, h2 = 0, h3 = 0, h4 = 0, h5 = 0, h6 = 0, h7 = 0;
+  for(uint16_t i = 0; i < count; i++, x += dx) {
+    uint8_t X = x>>8;
+    if(X != lastX) {
+      lastX = X;
+      uint8_t A = P(X)+Y;
+      uint8_t AA = P(A)+Z;
+      uint8_t AB = P(A+1)+Z;
+      uint8_t B = P(X+1)+Y;
+      uint8_t BA = P(B) + Z;
+      uint8_t BB = P(B+1)+Z;
+      h0 = P(AA); h1 = P(BA); h2 = P(AB); h3 = P(BB);
+      h4 = P(AA+1); h5 = P(BA+1); h6 = P(AB+1); h7 = P(BB+1);
+    }
+
+    uint8_t u = x;
+    int8_t xx = ((uint8_t)(x)>>1) & 0x7F;
+    u = scale8(u,u);
+
+    int8_t X1 = lerp7by8(grad8(h0, xx, yy, zz), grad8(h1, xx - N, yy, zz), u);
+    int8_t X2 = lerp7by8(grad8(h2, xx, yy-N, zz), grad8(h3, xx - N, yy - N, zz), u);
+    int8_t X3 = lerp7by8(grad8(h4, xx, yy, zz-N), grad8(h5, xx - N, yy, zz-N), u);
+    int8_t X4 = lerp7by8(grad8(h6, xx, yy-N, zz-N), grad8(h7, xx - N, yy - N, zz - N), u);
+
+    int8_t Y1 = lerp7by8(X1,X2,v);
+    int8_t Y2 = lerp7by8(X3,X4,v);
+
+    sink(i, lerp7by8(Y1,Y2,w));
+  }
+}
+
+template<class SINK>
+static void inoise8_raw_run(uint16_t x, uint16_t dx, uint16_t count, uint16_t y, SINK sink)
+{
+  uint8_t Y = y>>8;
+  uint8_t v = y;
+  int8_t yy = ((uint8_t)(y)>>1) & 0x7F;
+  uint8_t N = 0x80;
+  v = scale8(v,v);
+
+  uint16_t lastX = 0x100;
+  uint8_t h0 = 0, h1 = 0, h2 = 0, h3 = 0;
+  for(uint16_t i = 0; i < count; i++, x += dx) {
+    uint8_t X = x>>8;
+    if(X != lastX) {
+      lastX = X;
+      uint8_t A = P(X)+Y;
+      uint8_t B = P(X+1)+Y;
+      h0 = P(P(A)); h1 = P(P(B)); h2 = P(P(A+1)); h3 = P(P(B+1));
+    }
+
+    uint8_t u = x;
+    int8_t xx = ((uint8_t)(x)>>1) & 0x7F;
+    u = scale8(u,u);
+
+    int8_t X1 = lerp7by8(grad8(h0, xx, yy), grad8(h1, xx - N, yy), u);
+    int8_t X2 = lerp7by8(grad8(h2, xx, yy-N), grad8(h3, xx - N, yy - N), u);
+
+    sink(i, lerp7by8(X1,X2,v));
+  }
+}
+
+void inoise16_raw_array(int16_t *pOut, uint16_t count, uint32_t x, uint32_t dx, uint32_t y, uint32_t z) {
+#if FASTLED_NOISE_LANES > 1
+  inoise16_raw_lanes<CNoiseLanes>(pOut, count, x, dx, y, z);
+#else
+  inoise16_raw_run(x, dx, count, y, z, [&](uint16_t i, int16_t raw) { pOut[i] = raw; });
+#endif
+}
+
+void inoise16_raw_array(int16_t *pOut, uint16_t count, uint32_t x, uint32_t dx, uint32_t y) {
+#if FASTLED_NOISE_LANES > 1
+  inoise16_raw_lanes<CNoiseLanes>(pOut, count, x, dx, y);
+#else
+  inoise16_raw_run(x, dx, count, y, [&](uint16_t i, int16_t raw) { pOut[i] = raw; });
+#endif
+}
+
 // struct q44 {
 //   uint8_t i:4;
 //   uint8_t f:4;
@@ -519,9 +1023,9 @@ void fill_raw_noise8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint16
   uint32_t _xx = x;
   uint32_t scx = scale;
   for(int o = 0; o < octaves; o++) {
-    for(int i = 0,xx=_xx; i < num_points; i++, xx+=scx) {
-          pData[i] = qadd8(pData[i],inoise8(xx,time)>>o);
-    }
+    inoise8_raw_run(_xx, scx, num_points, time, [&](uint16_t i, int8_t raw) {
+      pData[i] = qadd8(pData[i],noise8_scale2d(raw)>>o);
+    });
 
     _xx <<= 1;
     scx <<= 1;
@@ -532,12 +1036,12 @@ void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves,
   uint32_t _xx = x;
   uint32_t scx = scale;
   for(int o = 0; o < octaves; o++) {
-    for(int i = 0,xx=_xx; i < num_points; i++, xx+=scx) {
-      uint32_t accum = (inoise16(xx,time))>>o;
+    inoise16_raw_run(_xx, scx, num_points, time, [&](uint16_t i, int16_t raw) {
+      uint32_t accum = (noise16_scale2d(raw))>>o;
       accum += (pData[i]<<8);
       if(accum > 65535) { accum = 65535; }
       pData[i] = accum>>8;
-    }
+    });
 
     _xx <<= 1;
     scx <<= 1;
@@ -556,12 +1060,10 @@ void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, q
   scaley *= skip;
 
   fract8 invamp = 255-amplitude;
-  uint16_t xx = x;
   for(int i = 0; i < height; i++, y+=scaley) {
     uint8_t *pRow = pData + (i*width);
-    xx = x;
-    for(int j = 0; j < width; j++, xx+=scalex) {
-      uint8_t noise_base = inoise8(xx,y,time);
+    inoise8_raw_run(x, scalex, width, y, time, [&](uint16_t j, int8_t raw) {
+      uint8_t noise_base = noise8_scale3d(raw);
       noise_base = (0x80 & noise_base) ? (noise_base - 127) : (127 - noise_base);
       noise_base = scale8(noise_base<<1,amplitude);
       if(skip == 1) {
@@ -574,7 +1076,7 @@ void fill_raw_2dnoise8(uint8_t *pData, int width, int height, uint8_t octaves, q
           }
         }
       }
-    }
+    });
   }
 }
 
@@ -595,8 +1097,9 @@ void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves,
   fract16 invamp = 65535-amplitude;
   for(int i = 0; i < height; i+=skip, y+=scaley) {
     uint16_t *pRow = pData + (i*width);
-    for(int j = 0,xx=x; j < width; j+=skip, xx+=scalex) {
-      uint16_t noise_base = inoise16(xx,y,time);
+    inoise16_raw_run(x, scalex, (width+skip-1)/skip, y, time, [&](uint16_t k, int16_t raw) {
+      int j = k*skip;
+      uint16_t noise_base = noise16_scale3d(raw);
       noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
       noise_base = scale16(noise_base<<1, amplitude);
       if(skip==1) {
@@ -609,7 +1112,7 @@ void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves,
           }
         }
       }
-    }
+    });
   }
 }
 
@@ -626,13 +1129,12 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
 
   scalex *= skip;
   scaley *= skip;
-  uint32_t xx;
   fract8 invamp = 255-amplitude;
   for(int i = 0; i < height; i+=skip, y+=scaley) {
     uint8_t *pRow = pData + (i*width);
-    xx = x;
-    for(int j = 0; j < width; j+=skip, xx+=scalex) {
-      uint16_t noise_base = inoise16(xx,y,time);
+    inoise16_raw_run(x, scalex, (width+skip-1)/skip, y, time, [&](uint16_t k, int16_t raw) {
+      int j = k*skip;
+      uint16_t noise_base = noise16_scale3d(raw);
       noise_base = (0x8000 & noise_base) ? noise_base - (32767) : 32767 - noise_base;
       noise_base = scale8(noise_base>>7,amplitude);
       if(skip==1) {
@@ -645,7 +1147,7 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
           }
         }
       }
-    }
+    });
   }
 }
 
@@ -653,21 +1155,39 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
   fill_raw_2dnoise16into8(pData, width, height, octaves, q44(2,0), 171, 1, x, scalex, y, scaley, time);
 }
 
+void CNoiseField::fill(uint8_t *pData, uint8_t num_points) const {
+  memset(pData,0,num_points);
+  fill_raw_noise16into8(pData,num_points,m_octaves,m_x,m_scalex,m_time);
+}
+
+void CNoiseField::fill(uint8_t *pData, int width, int height) const {
+  memset(pData,0,width*height);
+  fill_raw_2dnoise16into8(pData,width,height,m_octaves,m_x,m_scalex,m_y,m_scaley,m_time);
+}
+
+// The fill functions below that don't need whole noise planes work on
+// runs of NOISE_RUN points at a time.
 void fill_noise8(CRGB *leds, int num_leds,
             uint8_t octaves, uint16_t x, int scale,
             uint8_t hue_octaves, uint16_t hue_x, int hue_scale,
             uint16_t time) {
-  uint8_t V[num_leds];
-  uint8_t H[num_leds];
-
-  memset(V,0,num_leds);
-  memset(H,0,num_leds);
-
-  fill_raw_noise8(V,num_leds,octaves,x,scale,time);
-  fill_raw_noise8(H,num_leds,hue_octaves,hue_x,hue_scale,time);
-
-  for(int i = 0; i < num_leds; i++) {
-    leds[i] = CHSV(H[i],255,V[i]);
+  // Every point sums its own octaves, so the strip can be done a run at
+  // a time: the octaves of a run starting at point k start where they
+  // would have for point k of the whole strip.
+  for(int k = 0; k < num_leds; k += NOISE_RUN) {
+    uint8_t n = (num_leds - k < NOISE_RUN) ? (num_leds - k) : NOISE_RUN;
+    uint8_t V[NOISE_RUN];
+    uint8_t H[NOISE_RUN];
+
+    memset(V,0,n);
+    memset(H,0,n);
+
+    fill_raw_noise8(V,n,octaves,x + k*scale,scale,time);
+    fill_raw_noise8(H,n,hue_octaves,hue_x + k*hue_scale,hue_scale,time);
+
+    for(int i = 0; i < n; i++) {
+      leds[k+i] = CHSV(H[i],255,V[i]);
+    }
   }
 }
 
@@ -675,89 +1195,280 @@ void fill_noise16(CRGB *leds, int num_leds,
             uint8_t octaves, uint16_t x, int scale,
             uint8_t hue_octaves, uint16_t hue_x, int hue_scale,
             uint16_t time) {
-  uint8_t V[num_leds];
-  uint8_t H[num_leds];
+  for(int k = 0; k < num_leds; k += NOISE_RUN) {
+    uint8_t n = (num_leds - k < NOISE_RUN) ? (num_leds - k) : NOISE_RUN;
+    uint8_t V[NOISE_RUN];
+    uint8_t H[NOISE_RUN];
 
-  memset(V,0,num_leds);
-  memset(H,0,num_leds);
+    memset(V,0,n);
+    memset(H,0,n);
 
-  fill_raw_noise16into8(V,num_leds,octaves,x,scale,time);
-  fill_raw_noise8(H,num_leds,hue_octaves,hue_x,hue_scale,time);
+    fill_raw_noise16into8(V,n,octaves,(uint32_t)x + (uint32_t)(k*scale),scale,time);
+    fill_raw_noise8(H,n,hue_octaves,hue_x + k*hue_scale,hue_scale,time);
 
-  for(int i = 0; i < num_leds; i++) {
-    leds[i] = CHSV(H[i],255,V[i]);
+    for(int i = 0; i < n; i++) {
+      leds[k+i] = CHSV(H[i],255,V[i]);
+    }
   }
 }
 
 void fill_2dnoise8(CRGB *leds, int width, int height, bool serpentine,
             uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
             uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend) {
-  uint8_t V[height][width];
-  uint8_t H[height][width];
+  CMatrixLayout layout(width, height, serpentine ? MATRIX_SERPENTINE : MATRIX_ROW_MAJOR);
+  fill_2dnoise8(leds, layout, octaves, x, xscale, y, yscale, time,
+                hue_octaves, hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend);
+}
 
-  memset(V,0,height*width);
-  memset(H,0,height*width);
+void fill_2dnoise16(CRGB *leds, int width, int height, bool serpentine,
+            uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift) {
+  CMatrixLayout layout(width, height, serpentine ? MATRIX_SERPENTINE : MATRIX_ROW_MAJOR);
+  fill_2dnoise16(leds, layout, octaves, x, xscale, y, yscale, time,
+                 hue_octaves, hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend, hue_shift);
+}
 
-  fill_raw_2dnoise8((uint8_t*)V,width,height,octaves,x,xscale,y,yscale,time);
-  fill_raw_2dnoise8((uint8_t*)H,width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+static void inline __attribute__((always_inline)) fill_2dnoise_pixel(CRGB &pixel, uint8_t hue, uint8_t sat, uint8_t val, bool blend) {
+  CRGB led(CHSV(hue,sat,val));
 
-  int w1 = width-1;
-  int h1 = height-1;
-  for(int i = 0; i < height; i++) {
+  if(blend) {
+    pixel >>= 1; pixel += (led>>=1);
+  } else {
+    pixel = led;
+  }
+}
+
+// Write the V (value) and H (hue) planes out through the layout.  The
+// hue plane is read back to front, as it always has been.
+static void fill_2dnoise_leds(CRGB *leds, const CMatrixLayout& layout,
+            const uint8_t *V, const uint8_t *H, uint8_t hue_shift, uint8_t sat, bool blend) {
+  int width = layout.width;
+  int last = layout.size() - 1;
+  for(int i = 0; i < layout.height; i++) {
     int wb = i*width;
     for(int j = 0; j < width; j++) {
-      CRGB led(CHSV(H[h1-i][w1-j],255,V[i][j]));
+      fill_2dnoise_pixel(leds[layout.index(j,i)], hue_shift + H[last-(wb+j)], sat, V[wb+j], blend);
+    }
+  }
+}
 
-      int pos = j;
-      if(serpentine && (i & 0x1)) {
-        pos = w1-j;
+// One octave of value and one of hue: every point is independent, so
+// compute a run of V and H at a time and write them straight out.
+// The hue for (i,j) comes from plane point (h1-i,w1-j), so each hue
+// run is computed left to right from its far end and read backwards.
+static void fill_2dnoise8_runs(CRGB *leds, const CMatrixLayout& layout,
+            uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
+            uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend) {
+  int w1 = layout.width-1;
+  int h1 = layout.height-1;
+  for(int i = 0; i < layout.height; i++) {
+    for(int j = 0; j < layout.width; j += NOISE_RUN) {
+      uint8_t n = (layout.width - j < NOISE_RUN) ? (layout.width - j) : NOISE_RUN;
+      uint8_t V[NOISE_RUN];
+      uint8_t H[NOISE_RUN];
+      int hj = w1 - j - (n - 1);
+
+      memset(V,0,n);
+      memset(H,0,n);
+
+      fill_raw_2dnoise8(V,n,1,1,x + j*xscale,xscale,y + i*yscale,yscale,time);
+      fill_raw_2dnoise8(H,n,1,1,hue_x + hj*hue_xscale,hue_xscale,hue_y + (h1-i)*hue_yscale,hue_yscale,hue_time);
+
+      for(int k = 0; k < n; k++) {
+        fill_2dnoise_pixel(leds[layout.index(j+k,i)], H[n-1-k], 255, V[k], blend);
       }
+    }
+  }
+}
 
-      if(blend) {
-        leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
-      } else {
-        leds[wb+pos] = led;
+static void fill_2dnoise16_runs(CRGB *leds, const CMatrixLayout& layout,
+            uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
+            uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint8_t hue_shift) {
+  int w1 = layout.width-1;
+  int h1 = layout.height-1;
+  for(int i = 0; i < layout.height; i++) {
+    for(int j = 0; j < layout.width; j += NOISE_RUN) {
+      uint8_t n = (layout.width - j < NOISE_RUN) ? (layout.width - j) : NOISE_RUN;
+      uint8_t V[NOISE_RUN];
+      uint8_t H[NOISE_RUN];
+      int hj = w1 - j - (n - 1);
+
+      memset(V,0,n);
+      memset(H,0,n);
+
+      fill_raw_2dnoise16into8(V,n,1,1,q44(2,0),171,1,x + (uint32_t)(j*xscale),xscale,y + (uint32_t)(i*yscale),yscale,time);
+      fill_raw_2dnoise8(H,n,1,1,hue_x + hj*hue_xscale,hue_xscale,hue_y + (h1-i)*hue_yscale,hue_yscale,hue_time);
+
+      for(int k = 0; k < n; k++) {
+        fill_2dnoise_pixel(leds[layout.index(j+k,i)], hue_shift + H[n-1-k], 196, V[k], blend);
       }
     }
   }
 }
 
-void fill_2dnoise16(CRGB *leds, int width, int height, bool serpentine,
+static void fill_2dnoise8_planes(CRGB *leds, const CMatrixLayout& layout, uint8_t *V, uint8_t *H,
+            uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend) {
+  int width = layout.width;
+  int height = layout.height;
+
+  memset(V,0,height*width);
+  memset(H,0,height*width);
+
+  fill_raw_2dnoise8(V,width,height,octaves,x,xscale,y,yscale,time);
+  fill_raw_2dnoise8(H,width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+
+  fill_2dnoise_leds(leds, layout, V, H, 0, 255, blend);
+}
+
+static void fill_2dnoise16_planes(CRGB *leds, const CMatrixLayout& layout, uint8_t *V, uint8_t *H,
             uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
             uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift) {
-  uint8_t V[height][width];
-  uint8_t H[height][width];
+  int width = layout.width;
+  int height = layout.height;
 
   memset(V,0,height*width);
   memset(H,0,height*width);
 
-  fill_raw_2dnoise16into8((uint8_t*)V,width,height,octaves,q44(2,0),171,1,x,xscale,y,yscale,time);
-  // fill_raw_2dnoise16into8((uint8_t*)V,width,height,octaves,x,xscale,y,yscale,time);
-  // fill_raw_2dnoise8((uint8_t*)V,width,height,hue_octaves,x,xscale,y,yscale,time);
-  fill_raw_2dnoise8((uint8_t*)H,width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
+  fill_raw_2dnoise16into8(V,width,height,octaves,q44(2,0),171,1,x,xscale,y,yscale,time);
+  // fill_raw_2dnoise16into8(V,width,height,octaves,x,xscale,y,yscale,time);
+  // fill_raw_2dnoise8(V,width,height,hue_octaves,x,xscale,y,yscale,time);
+  fill_raw_2dnoise8(H,width,height,hue_octaves,hue_x,hue_xscale,hue_y,hue_yscale,hue_time);
 
+  fill_2dnoise_leds(leds, layout, V, H, hue_shift >> 8, 196, blend);
+}
 
-  int w1 = width-1;
-  int h1 = height-1;
-  hue_shift >>= 8;
+#if FASTLED_NOISE_SCRATCH_SIZE > 0
+static uint8_t gNoiseScratch[FASTLED_NOISE_SCRATCH_SIZE];
+#endif
 
-  for(int i = 0; i < height; i++) {
-    int wb = i*width;
-    for(int j = 0; j < width; j++) {
-      CRGB led(CHSV(hue_shift + (H[h1-i][w1-j]),196,V[i][j]));
+// Both planes for the layout, from the library's buffer if they fit,
+// otherwise from the heap; release_noise_planes gives them back.
+static uint8_t *get_noise_planes(const CMatrixLayout& layout) {
+#if FASTLED_NOISE_SCRATCH_SIZE > 0
+  if(2 * (uint32_t)layout.size() <= FASTLED_NOISE_SCRATCH_SIZE) {
+    return gNoiseScratch;
+  }
+#endif
+  return (uint8_t*)malloc(2 * (uint32_t)layout.size());
+}
 
-      int pos = j;
-      if(serpentine && (i & 0x1)) {
-        pos = w1-j;
-      }
+static void release_noise_planes(uint8_t *planes) {
+#if FASTLED_NOISE_SCRATCH_SIZE > 0
+  if(planes == gNoiseScratch) { return; }
+#endif
+  free(planes);
+}
 
-      if(blend) {
-        leds[wb+pos] >>= 1; leds[wb+pos] += (led>>=1);
-      } else {
-        leds[wb+pos] = led;
-      }
-    }
+void fill_2dnoise8(CRGB *leds, const CMatrixLayout& layout,
+            uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend) {
+  if(octaves <= 1 && hue_octaves <= 1) {
+    fill_2dnoise8_runs(leds, layout, x, xscale, y, yscale, time,
+                       hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend);
+    return;
   }
+
+  uint8_t *planes = get_noise_planes(layout);
+  if(!planes) { return; }
+  fill_2dnoise8_planes(leds, layout, planes, planes + layout.size(), octaves, x, xscale, y, yscale, time,
+                       hue_octaves, hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend);
+  release_noise_planes(planes);
+}
+
+void fill_2dnoise16(CRGB *leds, const CMatrixLayout& layout,
+            uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift) {
+  if(octaves <= 1 && hue_octaves <= 1) {
+    fill_2dnoise16_runs(leds, layout, x, xscale, y, yscale, time,
+                        hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend, hue_shift >> 8);
+    return;
+  }
+
+  uint8_t *planes = get_noise_planes(layout);
+  if(!planes) { return; }
+  fill_2dnoise16_planes(leds, layout, planes, planes + layout.size(), octaves, x, xscale, y, yscale, time,
+                        hue_octaves, hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend, hue_shift);
+  release_noise_planes(planes);
+}
+
+bool fill_2dnoise8(CRGB *leds, const CMatrixLayout& layout, CScratchArena& scratch,
+            uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend) {
+  if(octaves <= 1 && hue_octaves <= 1) {
+    fill_2dnoise8_runs(leds, layout, x, xscale, y, yscale, time,
+                       hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend);
+    return true;
+  }
+
+  uint16_t mark = scratch.mark();
+  uint8_t *V = (uint8_t*)scratch.alloc(layout.size());
+  uint8_t *H = (uint8_t*)scratch.alloc(layout.size());
+  if(V && H) {
+    fill_2dnoise8_planes(leds, layout, V, H, octaves, x, xscale, y, yscale, time,
+                         hue_octaves, hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend);
+  }
+  scratch.rewind(mark);
+  return V && H;
+}
+
+bool fill_2dnoise16(CRGB *leds, const CMatrixLayout& layout, CScratchArena& scratch,
+            uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift) {
+  if(octaves <= 1 && hue_octaves <= 1) {
+    fill_2dnoise16_runs(leds, layout, x, xscale, y, yscale, time,
+                        hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend, hue_shift >> 8);
+    return true;
+  }
+
+  uint16_t mark = scratch.mark();
+  uint8_t *V = (uint8_t*)scratch.alloc(layout.size());
+  uint8_t *H = (uint8_t*)scratch.alloc(layout.size());
+  if(V && H) {
+    fill_2dnoise16_planes(leds, layout, V, H, octaves, x, xscale, y, yscale, time,
+                          hue_octaves, hue_x, hue_xscale, hue_y, hue_yscale, hue_time, blend, hue_shift);
+  }
+  scratch.rewind(mark);
+  return V && H;
 }
 
 FASTLED_NAMESPACE_END
+
+
+#if 0
+// TEST / VERIFICATION CODE ONLY BELOW THIS POINT
+#include <Arduino.h>
+#include "FastLED.h"
+
+// inoise16_raw_array must match inoise16_raw exactly: check it over a
+// large set of random lines (any start, any step, including negative and
+// wrapping ones), then over every fraction of one lattice cell.
+void testnoiselanes()
+{
+  delay(5000);
+  CRandomStream rng(37);
+  static int16_t out[1024];
+  uint32_t points = 0, bad = 0;
+
+  for(uint32_t t = 0; t < 20000; t++) {
+    uint16_t n = 1 + rng.random16(1024);
+    uint32_t x = rng.random32(), y = rng.random32(), z = rng.random32();
+    uint32_t dx = (t & 1) ? rng.random32() : (uint32_t)((int32_t)rng.random16(8000) - 4000);
+    inoise16_raw_array(out, n, x, dx, y, z);
+    for(uint16_t i = 0; i < n; i++) { if(out[i] != inoise16_raw(x + i*dx, y, z)) { bad++; } }
+    inoise16_raw_array(out, n, x, dx, y);
+    for(uint16_t i = 0; i < n; i++) { if(out[i] != inoise16_raw(x + i*dx, y)) { bad++; } }
+    points += 2 * n;
+  }
+
+  for(uint32_t x = 0x00420000; x < 0x00430000; x += 1024) {
+    inoise16_raw_array(out, 1024, x, 1, 0xFFFF, 0x8000);
+    for(uint16_t i = 0; i < 1024; i++) { if(out[i] != inoise16_raw(x + i, 0xFFFF, 0x8000)) { bad++; } }
+    points += 1024;
+  }
+
+  Serial.print("inoise16_raw_array: "); Serial.print(points);
+  Serial.print(" points, "); Serial.print(bad); Serial.println(" mismatches");
+  for(;;){};
+}
+#endif
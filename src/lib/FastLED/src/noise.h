@@ -75,6 +75,15 @@ extern int16_t inoise16_raw(uint32_t x, uint32_t y, uint32_t z);
 extern int16_t inoise16_raw(uint32_t x, uint32_t y);
 extern int16_t inoise16_raw(uint32_t x);
 
+// Raw 16 bit noise for count points along a line: pOut[i] is exactly
+// inoise16_raw(x + i*dx, y, z) (or inoise16_raw(x + i*dx, y)).  Several
+// neighbouring points are worked out together, with SSE2/AVX2 on x86
+// hosts and the packed halfword instructions on Cortex-M4; other chips
+// (including the Cortex-M3) run the scalar code.  The fill_raw_*noise16*
+// functions below go through the same code.
+extern void inoise16_raw_array(int16_t *pOut, uint16_t count, uint32_t x, uint32_t dx, uint32_t y, uint32_t z);
+extern void inoise16_raw_array(int16_t *pOut, uint16_t count, uint32_t x, uint32_t dx, uint32_t y);
+
 // 8 bit, fixed point implementation of perlin's Simplex Noise.  Coordinates are
 // 8.8 fixed point values, 16 bit integers with integral coordinates in the high 8
 // bits and fractional in the low 8 bits, and the function takes 1d, 2d, and 3d coordinate
@@ -99,6 +108,50 @@ void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octa
 void fill_raw_2dnoise16(uint16_t *pData, int width, int height, uint8_t octaves, q88 freq88, fract16 amplitude, int skip, uint32_t x, int scalex, uint32_t y, int scaley, uint32_t time);
 void fill_raw_2dnoise16into8(uint8_t *pData, int width, int height, uint8_t octaves, q44 freq44, fract8 amplitude, int skip, uint32_t x, int scalex, uint32_t y, int scaley, uint32_t time);
 
+// The fill_raw_* functions above work a scanline at a time: the terms that
+// only depend on y and time are worked out once per row, and the corner
+// hashes of a lattice cell once per cell rather than once per point, so
+// they cost less the more points share a cell (i.e. the smaller the
+// scale).  The results are the same, bit for bit, as calling inoise8 /
+// inoise16 for each point.
+
+// CNoiseField: a 1d strip or 2d matrix of 16 bit noise, rendered to 8 bit
+// values, that moves through time.  fill() gives exactly what
+// fill_raw_noise16into8 / fill_raw_2dnoise16into8 give for the field's
+// origin, scale, octaves and time, but overwrites pData instead of adding
+// to it.  Step it along once per frame:
+//
+//   CNoiseField field( 2, 3000, 3000);
+//   ...
+//   field.advanceTime( 1200);
+//   field.fill( brightness, 16, 16);
+class CNoiseField {
+public:
+  CNoiseField(uint8_t octaves = 1, int scalex = 1 << 12, int scaley = 1 << 12)
+    : m_x(0), m_y(0), m_time(0), m_scalex(scalex), m_scaley(scaley), m_octaves(octaves) {}
+
+  CNoiseField &setOrigin(uint32_t x, uint32_t y = 0) { m_x = x; m_y = y; return *this; }
+  CNoiseField &setScale(int scalex, int scaley) { m_scalex = scalex; m_scaley = scaley; return *this; }
+  CNoiseField &setOctaves(uint8_t octaves) { m_octaves = octaves; return *this; }
+  CNoiseField &setTime(uint32_t time) { m_time = time; return *this; }
+
+  // move through time, or scroll across the field
+  CNoiseField &advanceTime(int32_t dt) { m_time += dt; return *this; }
+  CNoiseField &advance(int32_t dx, int32_t dy = 0) { m_x += dx; m_y += dy; return *this; }
+
+  uint32_t getX() const { return m_x; }
+  uint32_t getY() const { return m_y; }
+  uint32_t getTime() const { return m_time; }
+
+  void fill(uint8_t *pData, uint8_t num_points) const;
+  void fill(uint8_t *pData, int width, int height) const;
+
+private:
+  uint32_t m_x, m_y, m_time;
+  int m_scalex, m_scaley;
+  uint8_t m_octaves;
+};
+
 // fill functions to fill leds with values based on noise functions.  These functions use the fill_raw_* functions as appropriate.
 void fill_noise8(CRGB *leds, int num_leds,
             uint8_t octaves, uint16_t x, int scale,
@@ -115,6 +168,73 @@ void fill_2dnoise16(CRGB *leds, int width, int height, bool serpentine,
             uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
             uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift=0);
 
+// As above, but writing through a matrix layout (serpentine, or the
+// table of a CLEDLayout) instead of a row-major/serpentine flag.
+void fill_2dnoise8(CRGB *leds, const CMatrixLayout& layout,
+            uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend);
+void fill_2dnoise16(CRGB *leds, const CMatrixLayout& layout,
+            uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift=0);
+
+// Scratch memory for the fill functions.
+//
+// None of the fill functions put arrays sized by the led count on the
+// stack.  fill_noise8/16, and fill_2dnoise8/16 with one octave of value
+// and one of hue, work out the noise for a short run of points at a time
+// and write it straight out as CRGB; they need no scratch space at all.
+//
+// With more than one octave, fill_2dnoise8/16 need two width x height
+// byte planes, because the coarser octaves are painted in blocks across
+// several rows.  They take them from:
+//   - a CScratchArena you pass in, which lets several effects share one
+//     buffer, or
+//   - otherwise a FASTLED_NOISE_SCRATCH_SIZE byte buffer of the library's
+//     own (define it to 0 to leave that out), and if that's too small,
+//     the heap for the duration of the call.
+//
+//   uint8_t scratchBuffer[ 2 * 32 * 32];
+//   CScratchArena scratch( scratchBuffer, sizeof(scratchBuffer));
+//   ...
+//   scratch.reset();
+//   fill_2dnoise16( leds, layout, scratch, 2, x, ...);
+class CScratchArena {
+public:
+  CScratchArena(void *buffer, uint16_t size) : m_pBase((uint8_t*)buffer), m_nSize(size), m_nUsed(0) {}
+
+  // NULL if there isn't room
+  void *alloc(uint16_t bytes) {
+    if(bytes > (uint16_t)(m_nSize - m_nUsed)) { return NULL; }
+    void *p = m_pBase + m_nUsed;
+    m_nUsed += bytes;
+    return p;
+  }
+
+  uint16_t mark() const { return m_nUsed; }
+  void rewind(uint16_t mark) { m_nUsed = mark; }
+  void reset() { m_nUsed = 0; }
+  uint16_t available() const { return m_nSize - m_nUsed; }
+
+private:
+  uint8_t *m_pBase;
+  uint16_t m_nSize;
+  uint16_t m_nUsed;
+};
+
+#ifndef FASTLED_NOISE_SCRATCH_SIZE
+#define FASTLED_NOISE_SCRATCH_SIZE 512
+#endif
+
+// As above, with the scratch planes (if needed) taken from 'scratch' and
+// given back before returning.  Returns false, having drawn nothing, if
+// 'scratch' didn't have room.
+bool fill_2dnoise8(CRGB *leds, const CMatrixLayout& layout, CScratchArena& scratch,
+            uint8_t octaves, uint16_t x, int xscale, uint16_t y, int yscale, uint16_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time,bool blend);
+bool fill_2dnoise16(CRGB *leds, const CMatrixLayout& layout, CScratchArena& scratch,
+            uint8_t octaves, uint32_t x, int xscale, uint32_t y, int yscale, uint32_t time,
+            uint8_t hue_octaves, uint16_t hue_x, int hue_xscale, uint16_t hue_y, uint16_t hue_yscale,uint16_t hue_time, bool blend, uint16_t hue_shift=0);
+
 FASTLED_NAMESPACE_END
 
 #endif
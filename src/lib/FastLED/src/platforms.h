@@ -14,6 +14,9 @@
 #include "platforms/arm/sam/fastled_arm_sam.h"
 #elif defined(STM32F10X_MD) || defined(STM32F2XX)
 #include "fastled_arm_stm32.h"
+#elif defined(FASTLED_HOST)
+// desktop build, for host checks
+#include "fastled_host.h"
 #else
 // AVR platforms
 #include "platforms/avr/fastled_avr.h"
@@ -0,0 +1,120 @@
+#define FASTLED_INTERNAL
+#include "FastLED.h"
+#include "postprocess.h"
+
+FASTLED_NAMESPACE_BEGIN
+
+CFramePostProcess::CFramePostProcess( float gamma)
+    : m_Lut( gamma), m_MaxPower_mW( 0), m_pGovernor( NULL),
+      m_Unscaled_mW( 0), m_LastBrightness( 0), m_bLimited( false)
+{
+}
+
+CFramePostProcess::CFramePostProcess( float gammaR, float gammaG, float gammaB)
+    : m_Lut( gammaR, gammaG, gammaB), m_MaxPower_mW( 0), m_pGovernor( NULL),
+      m_Unscaled_mW( 0), m_LastBrightness( 0), m_bLimited( false)
+{
+}
+
+void CFramePostProcess::setGamma( float gammaR, float gammaG, float gammaB)
+{
+    m_Lut.build( gammaR, gammaG, gammaB);
+}
+
+void CFramePostProcess::process( const CGammaLUT& lut, const CRGB* src, CRGB* dst,
+                                 uint16_t numLeds, uint32_t sums[3])
+{
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* lr = lut.r;
+    const uint8_t* lg = lut.g;
+    const uint8_t* lb = lut.b;
+    uint32_t red32 = 0, green32 = 0, blue32 = 0;
+
+    while( numLeds) {
+        uint8_t r = lr[ s[0] ];
+        uint8_t g = lg[ s[1] ];
+        uint8_t b = lb[ s[2] ];
+        d[0] = r;
+        d[1] = g;
+        d[2] = b;
+        red32   += r;
+        green32 += g;
+        blue32  += b;
+        s += 3;
+        d += 3;
+        numLeds--;
+    }
+
+    sums[0] = red32;
+    sums[1] = green32;
+    sums[2] = blue32;
+}
+
+void CFramePostProcess::show( uint8_t target_brightness)
+{
+    show( NULL, target_brightness);
+}
+
+void CFramePostProcess::show( const CRGB* src, uint8_t target_brightness)
+{
+    uint8_t brightness = measure( src, target_brightness);
+    if( m_pGovernor) {
+        m_pGovernor->showLeds();
+    } else {
+        FastLED.show( brightness);
+    }
+}
+
+uint8_t CFramePostProcess::measure( const CRGB* src, uint8_t target_brightness)
+{
+    // one pass over every controller's data: lookup + power totals
+    uint32_t unscaled_mW = 0;
+    CPowerLoad loads[FASTLED_POWER_MAX_CONTROLLERS];
+    uint8_t k = 0;
+    CLEDController *pCur = CLEDController::head();
+    while( pCur) {
+        CRGB* leds = pCur->leds();
+        uint16_t n = pCur->size();
+        uint32_t mW = 0;
+        uint32_t sums[3] = { 0, 0, 0 };
+        if( leds && n) {
+            process( m_Lut, src ? src : leds, leds, n, sums);
+            // what the controller will drive: each channel scaled by
+            // its correction and temperature (at full brightness)
+            CRGB adj = pCur->getAdjustment( 255);
+            for( uint8_t c = 0; c < 3; c++) {
+                sums[c] = ((uint64_t)sums[c] * adj.raw[c]) / 255;
+            }
+            mW = calculate_unscaled_power_mW_for_totals( sums[0], sums[1], sums[2], n);
+            if( src) { src += n; }
+        }
+        if( k < FASTLED_POWER_MAX_CONTROLLERS) {
+            CPowerLoad& load = loads[k];
+            load.red = sums[0];
+            load.green = sums[1];
+            load.blue = sums[2];
+            load.numLeds = n;
+            load.model = pCur->getPowerModel();
+        }
+        unscaled_mW += mW;
+        k++;
+        pCur = pCur->next();
+    }
+
+    uint8_t brightness = target_brightness;
+    if( m_pGovernor) {
+        uint8_t n = (k < FASTLED_POWER_MAX_CONTROLLERS) ? k : FASTLED_POWER_MAX_CONTROLLERS;
+        m_pGovernor->update( loads, n, target_brightness);
+        brightness = m_pGovernor->getBrightness( 0);
+    } else if( m_MaxPower_mW) {
+        brightness = calculate_max_brightness_for_power_mW( unscaled_mW, target_brightness, m_MaxPower_mW);
+    }
+
+    m_Unscaled_mW = unscaled_mW;
+    m_LastBrightness = brightness;
+    m_bLimited = m_pGovernor ? m_pGovernor->isCapped() : (brightness < target_brightness);
+    return brightness;
+}
+
+FASTLED_NAMESPACE_END
@@ -0,0 +1,140 @@
+#ifndef __INC_POSTPROCESS_H
+#define __INC_POSTPROCESS_H
+
+#include "FastLED.h"
+#include "controllerset.h"
+
+FASTLED_NAMESPACE_BEGIN
+
+// Fused per-frame post-processing.
+//
+// Without this, a frame is touched several times between the pattern
+// and the wire: napplyGamma_video() walks the buffer, then
+// show_at_max_brightness_for_power() walks it again to add up the
+// power, and only then does the controller scale each byte for
+// correction, temperature and brightness as it clocks it out.
+//
+// CFramePostProcess reads each pixel once.  Gamma is applied through
+// one CGammaLUT, built when the gamma is set; the same loop that looks
+// pixels up in it adds up the per-channel totals that the power
+// limiter needs.  The brightness that keeps the frame inside the power
+// budget then falls out of those totals, and is applied by the
+// controller, along with its correction and temperature, while it
+// writes the data out, which it does anyway.
+//
+// Example:
+//   CFramePostProcess post( 2.2);
+//   post.setMaxPowerInVoltsAndMilliamps( 5, 2000);
+//   ...
+//   void loop() {
+//       drawPattern( leds);
+//       post.show();        // instead of FastLED.show()
+//   }
+//
+// show() works in place on each controller's leds, so the pattern
+// has to redraw every pixel of every frame.  Patterns that build on
+// the previous frame (fadeToBlackBy trails, blur, etc.) should draw
+// into a buffer of their own and hand it to show( src):
+//   CRGB canvas[NUM_LEDS];
+//   CRGB leds[NUM_LEDS];   // attached to the controller
+//   ...
+//   post.show( canvas);
+//
+// Correction and temperature stay with each controller, and are
+// applied exactly as FastLED.show() would, so the bytes on the wire
+// are the same as napplyGamma_video() followed by FastLED.show().
+//
+// The power numbers are measured on the data after gamma, with each
+// channel's total scaled by that controller's correction and
+// temperature, i.e. on what the LEDs will really be driven with, and
+// use the calibration in power_mgt.cpp.  After each show() they stay
+// available from getUnscaledPower_mW() and friends.
+//
+// With a CPowerGovernor attached (setGovernor), the governor takes
+// over from the plain power limit: it gets each controller's numbers
+// from the same pass, and shows each controller at the brightness it
+// works out.
+//
+// When the controllers are in a CControllerSet, pass it to show() so the
+// frame goes out through the set rather than FastLED.show():
+//   post.show( controllers);
+//   post.show( controllers, canvas);
+
+class CFramePostProcess {
+public:
+    CFramePostProcess( float gamma = 1.0);
+    CFramePostProcess( float gammaR, float gammaG, float gammaB);
+
+    void setGamma( float gamma) { setGamma( gamma, gamma, gamma); }
+    void setGamma( float gammaR, float gammaG, float gammaB);
+
+    // zero = no power limit (the default)
+    void setMaxPowerInMilliwatts( uint32_t powerInmW) { m_MaxPower_mW = powerInmW; }
+    void setMaxPowerInVoltsAndMilliamps( uint8_t volts, uint32_t milliamps)
+    {
+        m_MaxPower_mW = (uint32_t)volts * milliamps;
+    }
+    uint32_t getMaxPowerInMilliwatts() const { return m_MaxPower_mW; }
+
+    // Hand the power limiting to a governor (NULL = back to the plain
+    // limit above).
+    void setGovernor( CPowerGovernor* governor) { m_pGovernor = governor; }
+
+    // Process every controller's leds in place and show them at no more
+    // than the given brightness (default: FastLED.getBrightness()).
+    void show( uint8_t target_brightness);
+    void show() { show( FastLED.getBrightness()); }
+
+    // Process src into the controllers' leds, leaving src untouched.
+    // src is laid out like the controllers' data: the first controller's
+    // leds first, then the next controller's, and so on.
+    void show( const CRGB* src, uint8_t target_brightness);
+    void show( const CRGB* src) { show( src, FastLED.getBrightness()); }
+
+#if __cplusplus >= 201103L
+    // As above, but shown through the given set of controllers.
+    template<typename... CONTROLLERS>
+    void show( CControllerSet<CONTROLLERS...>& set, const CRGB* src, uint8_t target_brightness)
+    {
+        uint8_t brightness = measure( src, target_brightness);
+        if( m_pGovernor) {
+            m_pGovernor->showLeds( set);
+        } else {
+            set.show( brightness);
+        }
+    }
+    template<typename... CONTROLLERS>
+    void show( CControllerSet<CONTROLLERS...>& set, const CRGB* src = NULL)
+    {
+        show( set, src, FastLED.getBrightness());
+    }
+#endif
+
+    // The fused pass on its own: dst[i] = lut( src[i]) (src may equal
+    // dst), returning the channel totals of what was written.
+    static void process( const CGammaLUT& lut, const CRGB* src, CRGB* dst,
+                         uint16_t numLeds, uint32_t sums[3]);
+
+    // Statistics from the last show()
+    uint32_t getUnscaledPower_mW() const { return m_Unscaled_mW; }  // LEDs at brightness 255
+    uint8_t  getLastBrightness() const { return m_LastBrightness; } // brightness shown (first controller)
+    bool     wasPowerLimited() const { return m_bLimited; }         // brightness lowered to fit
+
+private:
+    // The pass that show() makes before it shows anything: gamma into
+    // the controllers' leds, power totals, governor update.  Returns
+    // the brightness to show at, when there's no governor.
+    uint8_t measure( const CRGB* src, uint8_t target_brightness);
+
+    CGammaLUT m_Lut;
+
+    uint32_t  m_MaxPower_mW;
+    CPowerGovernor* m_pGovernor;
+    uint32_t  m_Unscaled_mW;
+    uint8_t   m_LastBrightness;
+    bool      m_bLimited;
+};
+
+FASTLED_NAMESPACE_END
+
+#endif
@@ -18,14 +18,15 @@ FASTLED_NAMESPACE_BEGIN
 // However, this is good enough for most cases, and almost certainly better
 // than no power management at all.
 //
-// You're welcome to adjust these values as needed; there may eventually be an API
-// for changing these on the fly, but it saves codespace and RAM to have them
-// be compile-time constants.
+// You're welcome to adjust these values as needed, either here or on
+// the fly with set_power_calibration().
 
-static const uint8_t gRed_mW   = 16 * 5; // 16mA @ 5v = 80mW
-static const uint8_t gGreen_mW = 11 * 5; // 11mA @ 5v = 55mW
-static const uint8_t gBlue_mW  = 15 * 5; // 15mA @ 5v = 75mW
-static const uint8_t gDark_mW  =  1 * 5; //  1mA @ 5v =  5mW
+// (This is also the power model for controllers that don't have one.)
+static CLinearPowerModel gPowerModel( CPowerCalibration(
+    16 * 5,  // red:   16mA @ 5v = 80mW
+    11 * 5,  // green: 11mA @ 5v = 55mW
+    15 * 5,  // blue:  15mA @ 5v = 75mW
+     1 * 5));// dark:   1mA @ 5v =  5mW
 
 // Alternate calibration by RAtkins via pre-PSU wattage measurments;
 // these are all probably about 20%-25% too high due to PSU heat losses,
@@ -65,15 +66,20 @@ uint32_t calculate_unscaled_power_mW( const CRGB* ledbuffer, uint16_t numLeds )
         count--;
     }
 
-    red32   *= gRed_mW;
-    green32 *= gGreen_mW;
-    blue32  *= gBlue_mW;
+    return calculate_unscaled_power_mW_for_totals( red32, green32, blue32, numLeds);
+}
+
+uint32_t calculate_unscaled_power_mW_for_totals( uint32_t red32, uint32_t green32, uint32_t blue32, uint16_t numLeds)
+{
+    const CPowerCalibration& cal = gPowerModel.calibration();
 
-    red32   >>= 8;
-    green32 >>= 8;
-    blue32  >>= 8;
+    // the totals go up to 255 * numLeds, so with calibrations over 255
+    // the products need more than 32 bits
+    uint32_t red_mW   = ((uint64_t)red32   * cal.red_mW)   >> 8;
+    uint32_t green_mW = ((uint64_t)green32 * cal.green_mW) >> 8;
+    uint32_t blue_mW  = ((uint64_t)blue32  * cal.blue_mW)  >> 8;
 
-    uint32_t total = red32 + green32 + blue32 + (gDark_mW * numLeds);
+    uint32_t total = red_mW + green_mW + blue_mW + ((uint32_t)cal.dark_mW * numLeds);
 
     return total;
 }
@@ -85,14 +91,21 @@ uint32_t calculate_unscaled_power_mW( const CRGB* ledbuffer, uint16_t numLeds )
 //  - no more than max_mW milliwatts
 uint8_t calculate_max_brightness_for_power_mW( uint8_t target_brightness, uint32_t max_power_mW)
 {
-    uint32_t total_mW = gMCU_mW;
+    uint32_t unscaled_led_mW = 0;
 
     CLEDController *pCur = CLEDController::head();
 	while(pCur) {
-        total_mW += calculate_unscaled_power_mW( pCur->leds(), pCur->size());
+        unscaled_led_mW += calculate_unscaled_power_mW( pCur->leds(), pCur->size());
 		pCur = pCur->next();
 	}
 
+    return calculate_max_brightness_for_power_mW( unscaled_led_mW, target_brightness, max_power_mW);
+}
+
+uint8_t calculate_max_brightness_for_power_mW( uint32_t unscaled_led_mW, uint8_t target_brightness, uint32_t max_power_mW)
+{
+    uint32_t total_mW = gMCU_mW + unscaled_led_mW;
+
 #if POWER_DEBUG_PRINT == 1
     Serial.print("power demand at full brightness mW = ");
     Serial.println( total_mW);
@@ -142,6 +155,87 @@ uint8_t calculate_max_brightness_for_power_mW( uint8_t target_brightness, uint32
 }
 
 
+void set_power_calibration( const CPowerCalibration& calibration)
+{
+    gPowerModel = CLinearPowerModel( calibration);
+}
+
+const CPowerCalibration& get_power_calibration()
+{
+    return gPowerModel.calibration();
+}
+
+const CPowerModel& power_model_for( const CPowerLoad& load)
+{
+    return load.model ? *load.model : gPowerModel;
+}
+
+
+uint8_t CPowerModel::brightness_within( const CPowerLoad& load, uint32_t budget_mW) const
+{
+    if( power_mW( load, 255) <= budget_mW) return 255;
+    // the highest brightness that fits is in [lo, hi)
+    uint16_t lo = 0, hi = 255;
+    while( hi - lo > 1) {
+        uint8_t mid = (lo + hi) / 2;
+        if( power_mW( load, mid) <= budget_mW) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// The channel part of a linear load at full brightness, in mW.
+static uint32_t linear_channel_mW( const CPowerCalibration& cal, const CPowerLoad& load)
+{
+    return ((uint64_t)load.red   * cal.red_mW +
+            (uint64_t)load.green * cal.green_mW +
+            (uint64_t)load.blue  * cal.blue_mW) >> 8;
+}
+
+uint32_t CLinearPowerModel::power_mW( const CPowerLoad& load, uint8_t brightness) const
+{
+    uint32_t channel_mW = linear_channel_mW( m_Cal, load);
+    return (((uint64_t)channel_mW * brightness) >> 8) + (uint32_t)m_Cal.dark_mW * load.numLeds;
+}
+
+uint8_t CLinearPowerModel::brightness_within( const CPowerLoad& load, uint32_t budget_mW) const
+{
+    uint32_t dark_mW = (uint32_t)m_Cal.dark_mW * load.numLeds;
+    if( budget_mW <= dark_mW) return 0;
+    uint32_t channel_mW = linear_channel_mW( m_Cal, load);
+    // the largest b with (channel_mW * b) >> 8 <= budget_mW - dark_mW
+    uint64_t within = (((uint64_t)(budget_mW - dark_mW + 1) << 8) - 1) / (channel_mW ? channel_mW : 1);
+    return (within > 255) ? 255 : within;
+}
+
+uint32_t CTablePowerModel::power_mW( const CPowerLoad& load, uint8_t brightness) const
+{
+    if( load.numLeds == 0) return 0;
+
+    // average channel level, 8.8, at this brightness
+    uint64_t total = (uint64_t)load.red + load.green + load.blue;
+    uint32_t level88 = ((total << 8) * brightness / 256) / (3 * (uint32_t)load.numLeds);
+    if( level88 > (255 << 8)) level88 = 255 << 8;
+
+    // where that falls in the table: segment 'seg', 'frac'/65536 of the way along it
+    uint8_t segments = m_nPoints - 1;
+    uint32_t pos = level88 * segments;           // in 1/(255*256)ths of a segment
+    uint8_t seg = pos / (255 << 8);
+    uint32_t frac = ((uint64_t)(pos - seg * (255 << 8)) << 16) / (255 << 8);
+    if( seg >= segments) {
+        seg = segments - 1;
+        frac = 65536;
+    }
+    int32_t a = m_pTable[seg];
+    int32_t b = m_pTable[seg + 1];
+    int32_t led_mW = a + (int32_t)(((int64_t)(b - a) * frac) >> 16);
+
+    return (uint32_t)led_mW * load.numLeds;
+}
+
 void set_max_power_indicator_LED( uint8_t pinNumber)
 {
     gMaxPowerIndicatorLEDPinNumber = pinNumber;
@@ -167,6 +261,16 @@ void show_at_max_brightness_for_power()
     FastLED.setBrightness( targetBrightness );
 }
 
+void show_at_max_brightness_for_power( uint32_t unscaled_led_mW)
+{
+    uint8_t targetBrightness = FastLED.getBrightness();
+    uint8_t max = calculate_max_brightness_for_power_mW( unscaled_led_mW, targetBrightness, gMaxPowerInMilliwatts);
+
+    FastLED.setBrightness( max );
+    FastLED.show();
+    FastLED.setBrightness( targetBrightness );
+}
+
 void delay_at_max_brightness_for_power( uint16_t ms)
 {
     uint8_t targetBrightness = FastLED.getBrightness();
@@ -177,4 +281,317 @@ void delay_at_max_brightness_for_power( uint16_t ms)
     FastLED.setBrightness( targetBrightness );
 }
 
+
+
+CPowerGovernor::CPowerGovernor()
+    : m_MaxPower_mW( 0), m_nControllers( 0),
+      m_Attack_ms( 0), m_Release_ms( 250),
+      m_bStarted( false), m_bCapped( false), m_LastUpdate_ms( 0)
+{
+    for( uint8_t i = 0; i < FASTLED_POWER_MAX_CONTROLLERS; i++) {
+        m_ControllerMax_mW[i] = 0;
+        m_Level[i] = 255 << 8;
+        m_Scale[i] = 255;
+    }
+    resetTelemetry();
+}
+
+void CPowerGovernor::setControllerMaxPowerInMilliwatts( uint8_t controller, uint32_t powerInmW)
+{
+    if( controller < FASTLED_POWER_MAX_CONTROLLERS) {
+        m_ControllerMax_mW[controller] = powerInmW;
+    }
+}
+
+void CPowerGovernor::resetTelemetry()
+{
+    m_Capped_ms = 0;
+    m_Running_ms = 0;
+    m_CappedFrames = 0;
+    m_Frames = 0;
+    m_LastPower_mW = 0;
+}
+
+uint8_t CPowerGovernor::getCappedPercent() const
+{
+    if( m_Running_ms == 0) return 0;
+    return ((uint64_t)m_Capped_ms * 100) / m_Running_ms;
+}
+
+// Frames further apart than this restart the governor's filter and
+// don't count towards its telemetry.
+#define POWER_GOVERNOR_MAX_GAP_MS 1000
+
+// What the leds of every controller draw with each shown at share/256
+// of its cap.
+static uint32_t power_at_share( const CPowerLoad* loads, const uint8_t* cap,
+                                uint8_t nControllers, uint16_t share)
+{
+    uint32_t total = 0;
+    for( uint8_t i = 0; i < nControllers; i++) {
+        total += power_model_for( loads[i]).power_mW( loads[i], ((uint16_t)cap[i] * share) >> 8);
+    }
+    return total;
+}
+
+void CPowerGovernor::update( const CPowerLoad* loads, uint8_t nControllers, uint8_t target_brightness)
+{
+    if( nControllers > FASTLED_POWER_MAX_CONTROLLERS) {
+        nControllers = FASTLED_POWER_MAX_CONTROLLERS;
+    }
+    m_nControllers = nControllers;
+
+    // the cap for each controller: the target, its own budget, ...
+    uint8_t cap[FASTLED_POWER_MAX_CONTROLLERS];
+    for( uint8_t i = 0; i < nControllers; i++) {
+        cap[i] = target_brightness;
+        if( m_ControllerMax_mW[i]) {
+            uint8_t within = power_model_for( loads[i]).brightness_within( loads[i], m_ControllerMax_mW[i]);
+            if( within < cap[i]) cap[i] = within;
+        }
+    }
+
+    // ... and the overall budget: if all of them at their caps is too
+    // much, find the largest share s/256 of every cap that fits
+    if( m_MaxPower_mW) {
+        uint32_t budget = (m_MaxPower_mW > gMCU_mW) ? (m_MaxPower_mW - gMCU_mW) : 0;
+        if( power_at_share( loads, cap, nControllers, 256) > budget) {
+            uint16_t lo = 0, hi = 256;
+            while( hi - lo > 1) {
+                uint16_t mid = (lo + hi) / 2;
+                if( power_at_share( loads, cap, nControllers, mid) <= budget) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            for( uint8_t i = 0; i < nControllers; i++) {
+                cap[i] = ((uint16_t)cap[i] * lo) >> 8;
+            }
+        }
+    }
+
+    // follow the caps through the attack/release filter; after a long
+    // gap (e.g. the lights were off) start again from the caps
+    uint32_t now = millis();
+    uint32_t dt = now - m_LastUpdate_ms;
+    m_LastUpdate_ms = now;
+    if( dt > POWER_GOVERNOR_MAX_GAP_MS) {
+        m_bStarted = false;
+    }
+    if( !m_bStarted) {
+        dt = 0;
+    }
+
+    bool capped = false;
+    uint32_t shown_mW = gMCU_mW;
+    for( uint8_t i = 0; i < nControllers; i++) {
+        int32_t want = (int32_t)cap[i] << 8;
+        int32_t level = m_Level[i];
+        uint16_t tau = (want < level) ? m_Attack_ms : m_Release_ms;
+        if( !m_bStarted || tau == 0) {
+            level = want;
+        } else {
+            int32_t step = ((want - level) * (int32_t)dt) / (int32_t)(tau + dt);
+            if( step == 0 && dt) step = (want > level) ? 1 : -1;
+            level += step;
+            // never overshoot
+            if( (step > 0 && level > want) || (step < 0 && level < want)) level = want;
+        }
+        m_Level[i] = level;
+        m_Scale[i] = level >> 8;
+        if( m_Scale[i] < target_brightness) capped = true;
+        shown_mW += power_model_for( loads[i]).power_mW( loads[i], m_Scale[i]);
+    }
+    m_bStarted = true;
+
+    m_bCapped = capped;
+    m_LastPower_mW = shown_mW;
+    m_Frames++;
+    m_Running_ms += dt;
+    if( capped) {
+        m_CappedFrames++;
+        m_Capped_ms += dt;
+    }
+
+#if POWER_LED > 0
+    if( gMaxPowerIndicatorLEDPinNumber ) {
+        digitalWrite( gMaxPowerIndicatorLEDPinNumber, capped ? HIGH : LOW);
+    }
+#endif
+}
+
+void CPowerGovernor::show( uint8_t target_brightness)
+{
+    CPowerLoad loads[FASTLED_POWER_MAX_CONTROLLERS];
+    uint8_t n = 0;
+    CLEDController *pCur = CLEDController::head();
+    while( pCur && n < FASTLED_POWER_MAX_CONTROLLERS) {
+        CPowerLoad& load = loads[n++];
+        load.red = load.green = load.blue = 0;
+        const uint8_t* p = (const uint8_t*)pCur->leds();
+        for( int count = p ? pCur->size() : 0; count; count--) {
+            load.red   += *p++;
+            load.green += *p++;
+            load.blue  += *p++;
+        }
+        load.numLeds = pCur->size();
+        load.model = pCur->getPowerModel();
+        pCur = pCur->next();
+    }
+    update( loads, n, target_brightness);
+    showLeds();
+}
+
+void CPowerGovernor::show()
+{
+    show( FastLED.getBrightness());
+}
+
+void CPowerGovernor::showLeds()
+{
+    FastLED.show( m_Scale, m_nControllers);
+}
+
+// The colorutils functions that CPowerTally's members wrap; the
+// members' own names hide them inside the class.
+static inline void blend_into( CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay)
+{
+    nblend( existing, overlay, amountOfOverlay);
+}
+
+static inline void gradient_into( CRGB* leds, uint16_t startpos, const CRGB& startcolor,
+                                  uint16_t endpos, const CRGB& endcolor)
+{
+    fill_gradient_RGB( leds, startpos, startcolor, endpos, endcolor);
+}
+
+CPowerTally::CPowerTally( CRGB* leds, uint16_t numLeds)
+    : m_pLeds( leds), m_nLeds( numLeds)
+{
+    recount();
+}
+
+void CPowerTally::recount()
+{
+    uint32_t red32 = 0, green32 = 0, blue32 = 0;
+    const uint8_t* p = (const uint8_t*)m_pLeds;
+    for( uint16_t count = m_nLeds; count; count--) {
+        red32   += *p++;
+        green32 += *p++;
+        blue32  += *p++;
+    }
+    m_Sums[0] = red32;
+    m_Sums[1] = green32;
+    m_Sums[2] = blue32;
+}
+
+void CPowerTally::fill_solid( uint16_t start, uint16_t count, const CRGB& color)
+{
+    uint32_t red32 = 0, green32 = 0, blue32 = 0;
+    CRGB* led = m_pLeds + start;
+    for( uint16_t i = 0; i < count; i++) {
+        red32   += led->r;
+        green32 += led->g;
+        blue32  += led->b;
+        *led++ = color;
+    }
+    m_Sums[0] += (uint32_t)color.r * count - red32;
+    m_Sums[1] += (uint32_t)color.g * count - green32;
+    m_Sums[2] += (uint32_t)color.b * count - blue32;
+}
+
+void CPowerTally::fill_gradient_RGB( uint16_t startpos, const CRGB& startcolor,
+                                     uint16_t endpos,   const CRGB& endcolor)
+{
+    // the range is added up before and after the gradient is drawn
+    // into it; only the range is read, not the whole array
+    if( endpos < startpos) {
+        fill_gradient_RGB( endpos, endcolor, startpos, startcolor);
+        return;
+    }
+    uint16_t count = endpos - startpos + 1;
+    CRGB* led = m_pLeds + startpos;
+    uint32_t before[3] = { 0, 0, 0 };
+    for( uint16_t i = 0; i < count; i++) {
+        before[0] += led[i].r;
+        before[1] += led[i].g;
+        before[2] += led[i].b;
+    }
+    gradient_into( m_pLeds, startpos, startcolor, endpos, endcolor);
+    for( uint16_t i = 0; i < count; i++) {
+        m_Sums[0] += led[i].r;
+        m_Sums[1] += led[i].g;
+        m_Sums[2] += led[i].b;
+    }
+    m_Sums[0] -= before[0];
+    m_Sums[1] -= before[1];
+    m_Sums[2] -= before[2];
+}
+
+void CPowerTally::nblend( uint16_t i, const CRGB& overlay, fract8 amountOfOverlay)
+{
+    CRGB blended = m_pLeds[i];
+    blend_into( blended, overlay, amountOfOverlay);
+    set( i, blended);
+}
+
+void CPowerTally::fadeToBlackBy( uint8_t fadeBy)
+{
+    // every led changes, so this is a recount done while scaling
+    uint8_t scale = 255 - fadeBy;
+    uint32_t red32 = 0, green32 = 0, blue32 = 0;
+    CRGB* led = m_pLeds;
+    for( uint16_t count = m_nLeds; count; count--) {
+        led->nscale8( scale);
+        red32   += led->r;
+        green32 += led->g;
+        blue32  += led->b;
+        led++;
+    }
+    m_Sums[0] = red32;
+    m_Sums[1] = green32;
+    m_Sums[2] = blue32;
+}
+
+FASTLED_NAMESPACE_END
+
+
+#ifdef POWER_MGT_HOST_CHECK
+// TEST / VERIFICATION CODE ONLY BELOW THIS POINT
+// Host check: random writes through a CPowerTally must leave its
+// totals equal to a full recount of the leds after every single one.
+// From this directory:
+//   g++ -std=gnu++11 -O2 -I. -DFASTLED_HOST -DPOWER_MGT_HOST_CHECK power_mgt.cpp FastLED.cpp colorutils.cpp lib8tion.cpp hsv2rgb.cpp && ./a.out
+#include <stdio.h>
+
+FASTLED_USING_NAMESPACE
+
+// colorutils.cpp wants one
+FASTLED_NAMESPACE_BEGIN
+uint16_t XY( uint8_t x, uint8_t y) { return (uint16_t)y * 16 + x; }
 FASTLED_NAMESPACE_END
+
+int main()
+{
+    static CRGB leds[300];
+    CPowerTally tally( leds, 300);
+    uint32_t bad = 0;
+
+    for( uint32_t i = 0; i < 1000000; i++) {
+        uint16_t a = random16( 300), b = random16( 300);
+        CRGB c( random8(), random8(), random8());
+        switch( random8( 5)) {
+            case 0: tally.set( a, c); break;
+            case 1: tally.fill_solid( a, random16( 300 - a + 1), c); break;
+            case 2: tally.fill_gradient_RGB( a, c, b, CRGB( random8(), random8(), random8())); break;
+            case 3: tally.nblend( a, c, random8()); break;
+            case 4: if( random8() < 5) tally.fadeToBlackBy( random8()); break;
+        }
+        if( tally.unscaled_mW() != calculate_unscaled_power_mW( leds, 300)) bad++;
+    }
+
+    printf( "CPowerTally: %u mismatches\n", (unsigned)bad);
+    return bad != 0;
+}
+#endif
@@ -16,6 +16,130 @@ void set_max_power_in_milliwatts( uint32_t powerInmW);
 void set_max_power_indicator_LED( uint8_t pinNumber); // zero = no indicator LED
 
 
+// Power calibration
+//
+// How much one led draws with one channel fully on, and with
+// everything off, in milliwatts.  The default is for 5V WS2812B-type
+// leds (80/55/75 mW per channel, 5 mW dark); see power_mgt.cpp.  It's
+// used by everything below that turns led data into milliwatts.
+//
+// Example, for 12V WS2811 strip where each "led" is a group of three
+// LEDs drawing about 20mA per channel:
+//   set_power_calibration( CPowerCalibration( 240, 240, 240, 12));
+//
+struct CPowerCalibration {
+    uint16_t red_mW;
+    uint16_t green_mW;
+    uint16_t blue_mW;
+    uint16_t dark_mW;
+
+    CPowerCalibration( uint16_t r, uint16_t g, uint16_t b, uint16_t dark)
+        : red_mW( r), green_mW( g), blue_mW( b), dark_mW( dark) {}
+};
+
+void set_power_calibration( const CPowerCalibration& calibration);
+const CPowerCalibration& get_power_calibration();
+
+
+// Power models
+//
+// The calibration above treats every led the same way: a fixed draw
+// per channel at full, scaled linearly, plus a little when dark.  A
+// CPowerModel says how one controller's leds turn into milliwatts
+// instead, and is attached to the controller:
+//   FastLED.addLeds<...>( leds, NUM_LEDS).setPowerModel( &model);
+// CPowerGovernor (and CFramePostProcess with a governor attached) use
+// each controller's model; controllers without one use the global
+// calibration.  The older show_at_max_brightness_for_power() and
+// calculate_* functions always use the global calibration.
+//
+// Models work from a CPowerLoad, the channel totals of a controller's
+// leds (as CPowerTally and CFramePostProcess already add up), and are
+// asked what those leds draw at a given brightness.  Power has to go
+// up with brightness, never down.
+//
+// There are three models:
+//   CLinearPowerModel  - a CPowerCalibration of its own; unlike the
+//                        calculate_* functions, the dark draw doesn't
+//                        get scaled down with the brightness.
+//   CGroupedPowerModel - constant-current drivers like 12V WS2811
+//                        strip, where each "led" is one IC driving a
+//                        group of LEDs in series.  Every channel draws
+//                        its set current for its PWM on-time, however
+//                        many LEDs are in the group, at the supply
+//                        voltage; the IC's own draw is constant.
+//   CTablePowerModel   - measured: the draw of one led against its
+//                        average channel level, at evenly spaced
+//                        levels from 0 to 255, interpolated between.
+//                        Measure it by setting every led to the same
+//                        grey at a few levels and reading the supply.
+//                        This picks up what the others can't, like
+//                        strings drawing less than linear at high
+//                        levels as the voltage along them sags, which
+//                        lets the limiter run brighter on the same
+//                        supply.
+//
+// Example, for 12V WS2811 strip at about 20mA per channel, 1mA per IC:
+//   CGroupedPowerModel stripModel( 12, 20, 1);
+// Example, measured (mW per led at levels 0, 64, 128, 192, 255):
+//   static const uint16_t stripTable[] = { 12, 170, 330, 470, 590 };
+//   CTablePowerModel stripModel( stripTable, 5);
+
+struct CPowerLoad {
+    uint32_t red, green, blue;   // channel totals over the leds
+    uint16_t numLeds;
+    const CPowerModel* model;    // NULL = the global calibration
+};
+
+class CPowerModel {
+public:
+    // What the leds draw, in mW, shown at 'brightness'.
+    virtual uint32_t power_mW( const CPowerLoad& load, uint8_t brightness) const = 0;
+
+    // The highest brightness at which they draw no more than
+    // budget_mW.  By default a binary search over power_mW().
+    virtual uint8_t brightness_within( const CPowerLoad& load, uint32_t budget_mW) const;
+};
+
+class CLinearPowerModel : public CPowerModel {
+public:
+    CLinearPowerModel( const CPowerCalibration& calibration) : m_Cal( calibration) {}
+
+    virtual uint32_t power_mW( const CPowerLoad& load, uint8_t brightness) const;
+    virtual uint8_t brightness_within( const CPowerLoad& load, uint32_t budget_mW) const;
+
+    const CPowerCalibration& calibration() const { return m_Cal; }
+
+protected:
+    CPowerCalibration m_Cal;
+};
+
+class CGroupedPowerModel : public CLinearPowerModel {
+public:
+    CGroupedPowerModel( uint8_t volts, uint16_t channel_mA, uint16_t ic_mA)
+        : CLinearPowerModel( CPowerCalibration( volts * channel_mA, volts * channel_mA,
+                                                volts * channel_mA, volts * ic_mA)) {}
+};
+
+class CTablePowerModel : public CPowerModel {
+public:
+    // led_mW[0..numPoints-1]: the draw of one led at average channel
+    // level 255 * i / (numPoints - 1).  numPoints >= 2; not copied.
+    CTablePowerModel( const uint16_t* led_mW, uint8_t numPoints)
+        : m_pTable( led_mW), m_nPoints( numPoints) {}
+
+    virtual uint32_t power_mW( const CPowerLoad& load, uint8_t brightness) const;
+
+private:
+    const uint16_t* m_pTable;
+    uint8_t m_nPoints;
+};
+
+// The model CPowerGovernor uses for a load: its own, or the global
+// calibration's.
+const CPowerModel& power_model_for( const CPowerLoad& load);
+
+
 // Power Control 'show' and 'delay' functions
 //
 // These are drop-in replacements for FastLED.show() and FastLED.delay()
@@ -41,9 +165,215 @@ void delay_at_max_brightness_for_power( uint16_t ms);
 //   takes a 'target brightness' which is the brightness you'd ideally like
 //   to use.  The result from this function will be no higher than the
 //   target_brightess you supply, but may be lower.
+//
+// calculate_unscaled_power_mW_for_totals does the same for code that has
+//   already added up each channel over numLeds leds.
+//
+// The three-argument calculate_max_brightness_for_power_mW takes the
+//   unscaled LED power from the caller instead of walking every
+//   controller's led data itself.
 uint32_t calculate_unscaled_power_mW( const CRGB* ledbuffer, uint16_t numLeds);
+uint32_t calculate_unscaled_power_mW_for_totals( uint32_t red32, uint32_t green32, uint32_t blue32, uint16_t numLeds);
 
 uint8_t  calculate_max_brightness_for_power_mW( uint8_t target_brightness, uint32_t max_power_mW);
+uint8_t  calculate_max_brightness_for_power_mW( uint32_t unscaled_led_mW, uint8_t target_brightness, uint32_t max_power_mW);
+
+
+// Incremental power accounting
+//
+// calculate_max_brightness_for_power_mW walks every byte of every
+// controller's leds each time it's called, which is a whole extra pass
+// over the frame.  A CPowerTally keeps running red, green and blue
+// totals for one led array instead, and the drawing code keeps them up
+// to date as it writes: every write through the tally takes the old
+// pixel out of the totals and puts the new one in.  The power the leds
+// would draw at full brightness is then a few multiplies, however many
+// leds there are.
+//
+// Only writes made through the tally are counted.  After writing to
+// the leds any other way, call recount(), which is the full pass again.
+//
+// Example:
+//   CPowerTally tally( leds, NUM_LEDS);
+//   ...
+//   tally.fadeToBlackBy( 20);
+//   tally.set( pos, CRGB::Red);
+//   show_at_max_brightness_for_power( tally.unscaled_mW());
+//
+// (With several controllers, add up each one's tally.unscaled_mW(), or
+// hand each one's tally.load() to CPowerGovernor::update().)
+class CPowerTally {
+public:
+    CPowerTally( CRGB* leds, uint16_t numLeds);
+
+    // Count the leds again from scratch.
+    void recount();
+
+    const CRGB& operator[]( uint16_t i) const { return m_pLeds[i]; }
+    uint16_t size() const { return m_nLeds; }
+
+    // leds[i] = color
+    void set( uint16_t i, const CRGB& color)
+    {
+        CRGB& led = m_pLeds[i];
+        m_Sums[0] += (int16_t)color.r - led.r;
+        m_Sums[1] += (int16_t)color.g - led.g;
+        m_Sums[2] += (int16_t)color.b - led.b;
+        led = color;
+    }
+
+    // The same as the colorutils functions of the same names, on the
+    // tally's leds.  These all read the pixels they overwrite in the
+    // same loop that writes them.
+    void fill_solid( uint16_t start, uint16_t count, const CRGB& color);
+    void fill_gradient_RGB( uint16_t startpos, const CRGB& startcolor,
+                            uint16_t endpos,   const CRGB& endcolor);
+    void nblend( uint16_t i, const CRGB& overlay, fract8 amountOfOverlay);
+    void fadeToBlackBy( uint8_t fadeBy);
+
+    // Channel totals over all the leds, and the power they'd draw at
+    // full brightness (see calculate_unscaled_power_mW).
+    uint32_t red() const   { return m_Sums[0]; }
+    uint32_t green() const { return m_Sums[1]; }
+    uint32_t blue() const  { return m_Sums[2]; }
+    uint32_t unscaled_mW() const
+    {
+        return calculate_unscaled_power_mW_for_totals( m_Sums[0], m_Sums[1], m_Sums[2], m_nLeds);
+    }
+
+    // The totals as a CPowerLoad, for CPowerGovernor::update()
+    CPowerLoad load( const CPowerModel* model = NULL) const
+    {
+        CPowerLoad l = { m_Sums[0], m_Sums[1], m_Sums[2], m_nLeds, model };
+        return l;
+    }
+
+private:
+    CRGB*    m_pLeds;
+    uint16_t m_nLeds;
+    uint32_t m_Sums[3];
+};
+
+// show_at_max_brightness_for_power for callers that already know the
+// unscaled power of all the controllers' leds, e.g. from CPowerTally.
+void show_at_max_brightness_for_power( uint32_t unscaled_led_mW);
+
+
+// Power governor
+//
+// show_at_max_brightness_for_power works out a new brightness cap from
+// scratch every frame, for all the leds together.  As the pattern
+// changes, the cap jumps up and down with it from one frame to the
+// next, and the strip visibly pumps.  CPowerGovernor is a stateful
+// replacement:
+//
+//   - a budget for everything together (including the MCU), and/or one
+//     per controller, e.g. for strips on separate supplies;
+//   - each controller's brightness follows its cap through an
+//     attack/release filter: it comes down at the 'attack' rate when
+//     it has to, and goes back up at the (slower) 'release' rate, so
+//     there is no pumping.  With attack at zero (the default), the
+//     budget is never exceeded;
+//   - telemetry: how long, and for how many frames, the brightness has
+//     been held below what was asked for, and the estimated draw of
+//     the last frame.
+//
+// The milliwatt figures come from each controller's power model.
+//
+// Example:
+//   CPowerGovernor governor;
+//   governor.setMaxPowerInVoltsAndMilliamps( 12, 4000);
+//   ...
+//   governor.show();            // instead of FastLED.show()
+//
+// show() adds up each controller's leds itself.  Callers that already
+// have each controller's channel totals (CPowerTally,
+// CFramePostProcess) hand them to update() and then call showLeds().
+// Only the first FASTLED_POWER_MAX_CONTROLLERS controllers are
+// governed; any after that are shown at the global brightness.
+
+#ifndef FASTLED_POWER_MAX_CONTROLLERS
+#define FASTLED_POWER_MAX_CONTROLLERS 8
+#endif
+
+class CPowerGovernor {
+public:
+    CPowerGovernor();
+
+    // Budget for all the controllers plus the MCU; zero = no limit.
+    void setMaxPowerInVoltsAndMilliamps( uint8_t volts, uint32_t milliamps)
+    {
+        m_MaxPower_mW = (uint32_t)volts * milliamps;
+    }
+    void setMaxPowerInMilliwatts( uint32_t powerInmW) { m_MaxPower_mW = powerInmW; }
+    uint32_t getMaxPowerInMilliwatts() const { return m_MaxPower_mW; }
+
+    // Budget for one controller's leds on their own (in FastLED[]
+    // order); zero = no limit of its own.
+    void setControllerMaxPowerInVoltsAndMilliamps( uint8_t controller, uint8_t volts, uint32_t milliamps)
+    {
+        setControllerMaxPowerInMilliwatts( controller, (uint32_t)volts * milliamps);
+    }
+    void setControllerMaxPowerInMilliwatts( uint8_t controller, uint32_t powerInmW);
+
+    // Time constants, in milliseconds, for the brightness to follow
+    // the cap down (attack) and back up (release).  Zero = at once.
+    void setAttackRelease( uint16_t attack_ms, uint16_t release_ms)
+    {
+        m_Attack_ms = attack_ms;
+        m_Release_ms = release_ms;
+    }
+
+    // Measure every controller's leds, update, and show them, each at
+    // its own brightness (default: FastLED.getBrightness()).
+    void show( uint8_t target_brightness);
+    void show();
+
+    // Work out each controller's brightness for a frame from its load
+    // (loads[i] for the i'th controller), then show them at those
+    // brightnesses.
+    void update( const CPowerLoad* loads, uint8_t nControllers, uint8_t target_brightness);
+    void showLeds();
+
+    // As showLeds(), but through a CControllerSet (or anything else
+    // with a show( scales, nScales)) instead of FastLED.show(), so the
+    // controllers' output isn't called through the vtable.
+    template<class SET> void showLeds( SET& set) { set.show( m_Scale, m_nControllers); }
+
+    // Brightness the i'th controller got from the last update()
+    uint8_t getBrightness( uint8_t controller) const
+    {
+        return (controller < m_nControllers) ? m_Scale[controller] : 0;
+    }
+
+    // Telemetry since the last resetTelemetry()
+    bool     isCapped() const         { return m_bCapped; }       // last frame below target
+    uint32_t getCappedMillis() const  { return m_Capped_ms; }     // time spent below target
+    uint32_t getRunningMillis() const { return m_Running_ms; }    // time covered by update()s
+    uint32_t getCappedFrames() const  { return m_CappedFrames; }
+    uint32_t getFrames() const        { return m_Frames; }
+    uint8_t  getCappedPercent() const;
+    uint32_t getLastPower_mW() const  { return m_LastPower_mW; }  // estimated draw, last frame
+    void     resetTelemetry();
+
+private:
+    uint32_t m_MaxPower_mW;
+    uint32_t m_ControllerMax_mW[FASTLED_POWER_MAX_CONTROLLERS];
+    uint16_t m_Level[FASTLED_POWER_MAX_CONTROLLERS];   // 8.8, filtered
+    uint8_t  m_Scale[FASTLED_POWER_MAX_CONTROLLERS];
+    uint8_t  m_nControllers;
+    uint16_t m_Attack_ms;
+    uint16_t m_Release_ms;
+    bool     m_bStarted;
+    bool     m_bCapped;
+    uint32_t m_LastUpdate_ms;
+
+    uint32_t m_Capped_ms;
+    uint32_t m_Running_ms;
+    uint32_t m_CappedFrames;
+    uint32_t m_Frames;
+    uint32_t m_LastPower_mW;
+};
 
 FASTLED_NAMESPACE_END
 
@@ -2,6 +2,9 @@
 #define FASTLED_ALLOW_INTERRUPTS 0
 
 #include "lib/FastLED/src/FastLED.h"
+#include "lib/FastLED/src/bench8.h"
+#include "lib/FastLED/src/controllerset.h"
+#include "lib/FastLED/src/postprocess.h"
 FASTLED_USING_NAMESPACE;
 
 #define PARTICLE_NO_ARDUINO_COMPATIBILITY 1
@@ -9,9 +12,23 @@ FASTLED_USING_NAMESPACE;
 
 #include "Particle.h"
 #include <palettes.h>
+#include <commands.h>
+#include <snapshot.h>
 #include <main.h>
 
-#define MAX_ARGS 64
+// Cloud commands waiting for loop(); see commands.h.
+#define COMMAND_QUEUE_SIZE 16
+// What the cloud functions return when the queue is full, or the
+// argument isn't what the function takes.
+#define CLOUD_QUEUE_FULL -1
+#define CLOUD_BAD_ARGS -2
+// CloudFunction::maxValues for functions that don't look at their
+// argument at all.
+#define ARGS_IGNORED 0xFF
+// The longest palette and brightness fade a scene can ask for.
+#define MAX_TRANSITION_MS 60000
+// How long MerryXMAS shows the red, green and white palette.
+#define MERRY_XMAS_MS 20000
 #define ARRAY_SIZE(A) (sizeof(A) / sizeof((A)[0]))
 
 #define NUM_LEDS 99
@@ -19,7 +36,22 @@ FASTLED_USING_NAMESPACE;
 #define COLOR_ORDER NSFastLED::RGB
 #define DATA_PIN D5
 #define MAX_BRIGHTNESS 255
-
+// The strip's power supply. gPowerGovernor keeps the leds and the MCU
+// together inside VOLTS x MAX_MA.
+#define VOLTS 12
+#define MAX_MA 4000
+// Gamma applied to each frame by gPostProcess, along with the color
+// correction. 1.0 leaves the twinkle colors as they are drawn.
+#define LED_GAMMA 1.0
+// Where the strip runs on the shelves, as a LAYOUT_WIDTH x LAYOUT_HEIGHT
+// grid: one segment per shelf, in wiring order (see kShelfSegments).
+#define LAYOUT_WIDTH NUM_LEDS
+#define LAYOUT_HEIGHT 1
+
+// The twinkle defaults. Each of these four can be changed at runtime
+// with the "twinkle" cloud function, and is then kept in EEPROM; the
+// per-pixel code is compiled separately for these values, and runs
+// that way while they're in use.
 #define TWINKLE_SPEED 3
 #define TWINKLE_DENSITY 5
 #define SECONDS_PER_PALETTE 20
@@ -28,10 +60,55 @@ FASTLED_USING_NAMESPACE;
 // fade out slighted 'reddened', similar to how
 // incandescent bulbs change color as they get dim down.
 #define COOL_LIKE_INCANDESCENT 0
+// If RUN_LIB8TION_BENCHMARK is set to 1, a table of the cycle cost of
+// each lib8tion primitive is printed over USB serial at boot.
+#define RUN_LIB8TION_BENCHMARK 0
+// If RUN_TWINKLE_BENCHMARK is set to 1, the cycle cost of a frame of
+// twinkles with the defaults compiled in and read at runtime is printed
+// over USB serial at boot.
+#define RUN_TWINKLE_BENCHMARK 0
+// Where the twinkle settings are kept in EEPROM, and the value that
+// marks them as there (bump it when TwinkleParams changes).
+#define EEPROM_TWINKLE_ADDRESS 0
+#define EEPROM_TWINKLE_MAGIC 0x5401
+// Where the light state snapshots are kept in EEPROM (see snapshot.h).
+#define EEPROM_SNAPSHOT_ADDRESS 16
 
 SYSTEM_MODE(SEMI_AUTOMATIC);
-
-CRGB leds[NUM_LEDS];
+// The cloud connection runs on its own thread, so the lights start and
+// keep going whether or not there's Wi-Fi; see ServiceCloud().
+SYSTEM_THREAD(ENABLED);
+// For the snapshot in backup RAM; see snapshot.h.
+STARTUP(System.enableFeature(FEATURE_RETAINED_MEMORY));
+
+// One spare pixel past the end for grid cells with no led behind them.
+CRGB leds_plus_safety_pixel[NUM_LEDS + 1];
+CRGB* const leds(leds_plus_safety_pixel);
+// Leds that aren't in any segment (e.g. hidden where the strip turns
+// the corner between two shelves) stay dark.
+const CLayoutSegment kShelfSegments[] = {
+    // first  count     x  y  reversed
+    {0, NUM_LEDS, 0, 0, false},
+};
+CLEDLayout<LAYOUT_WIDTH, LAYOUT_HEIGHT, NUM_LEDS> gLayout(
+    kShelfSegments, ARRAY_SIZE(kShelfSegments));
+// The strip's controller. Every frame goes out through gControllers
+// (gPostProcess.show(gControllers) hands it the governor's scale), so
+// its output code is inlined rather than called through the controller
+// list.
+CControllerSet<LED_TYPE<DATA_PIN, COLOR_ORDER> > gControllers;
+CFramePostProcess gPostProcess(LED_GAMMA);
+// 12V WS2811 strip: each led is a group of three LEDs on one
+// constant-current driver, about 20mA per channel whatever the supply
+// does, plus about 1mA for the driver itself.
+CGroupedPowerModel gStripPowerModel(VOLTS, 20, 1);
+CPowerGovernor gPowerGovernor;
+// Percentage of the time the governor has held the brightness down,
+// published as the "powerCapped" cloud variable.
+int gPowerCappedPercent = 0;
+// Milliseconds from power-up to the first frame shown, published as
+// the "bootToFrameMs" cloud variable; -1 until then.
+int gBootToFirstFrameMs = -1;
 CRGB gBackgroundColor = CRGB::Black;
 CRGBPalette16 gCurrentPalette;
 CRGBPalette16 gTargetPalette;
@@ -42,23 +119,104 @@ bool shouldChangePattern = false;
 bool lightState = false;
 bool currentState = true;
 bool cyclePatterns = true;
+// Where ChooseNextColorPalette() is in ActivePaletteList.
+uint8_t gPaletteIndex = ARRAY_SIZE(ActivePaletteList) - 1;
+const TwinkleParams kDefaultTwinkle = {TWINKLE_SPEED, TWINKLE_DENSITY,
+                                       SECONDS_PER_PALETTE,
+                                       COOL_LIKE_INCANDESCENT};
+TwinkleParams gTwinkle = kDefaultTwinkle;
+
+// A scene's fade from the palette and brightness that were showing to
+// gTargetPalette and lightBrightness; see ApplyScene().
+bool gSceneFading = false;
+uint32_t gSceneFadeStartMs = 0;
+uint16_t gSceneFadeMs = 0;
+CRGBPalette16 gSceneFadeFromPalette;
+uint8_t gSceneFadeFromBrightness = 0;
+
+SnapshotStore gSnapshots(EEPROM_SNAPSHOT_ADDRESS);
+
+CommandQueue<COMMAND_QUEUE_SIZE> gCommands;
+
+// Where ServiceCloud() has got to.
+enum CloudState {
+  kCloudOffline,     // Particle.connect() not called yet
+  kCloudConnecting,  // connecting, or reconnecting after losing the link
+  kCloudOnline,
+};
+CloudState gCloudState = kCloudOffline;
+bool gCloudPublished = false;
+// Set while MerryXMAS is showing; see ApplyCommand().
+bool gMerryXmas = false;
+bool gMerryXmasLightsWereOn = false;
+CRGBPalette16 gMerryXmasPalette;  // gCurrentPalette when it began
+uint32_t gMerryXmasStartMs = 0;
+
+// A cloud function: how many values its argument may have (see
+// CommandArgs in commands.h), and the handler that turns them into
+// commands for loop(). Particle calls Call() with the argument.
+struct CloudFunction {
+  const char *name;
+  uint8_t minValues;
+  uint8_t maxValues;  // or ARGS_IGNORED: don't even parse the argument
+  int (*handler)(const CommandArgs &args);
+
+  int Call(String args);
+};
+
+CloudFunction gCloudFunctions[] = {
+    {"lightsOn", 0, ARGS_IGNORED, CloudTurnLightsOn},
+    {"lightsOff", 0, ARGS_IGNORED, CloudTurnLightsOff},
+    {"toggleLights", 1, 1, CloudToggleLights},
+    {"brightness", 1, 1, CloudSetBrightness},
+    {"notify", 0, ARGS_IGNORED, CloudAlert},
+    {"nextPattern", 0, ARGS_IGNORED, CloudNextPattern},
+    {"MerryXMAS", 0, ARGS_IGNORED, CloudMerryXMAS},
+    {"scene", 2, 6, CloudScene},
+    {"twinkle", 1, 4, CloudTwinkle},
+};
 
 void setup() {
-  if (!Particle.connected()) {
-    Particle.connect();
-    waitFor(Particle.connected, 10000);
+  // Nothing in here waits on the cloud: the lights come back as they
+  // were, the first frame goes out on the first pass of loop(), and
+  // ServiceCloud() connects from there.
+  LoadTwinkleParams();
+  bool restored = RestoreSnapshot();
+
+  if (RUN_LIB8TION_BENCHMARK == 1) {
+    Serial.begin(9600);
+    delay(3000);
+    bench8_run([](const char *text) { Serial.print(text); });
+  }
+  if (RUN_TWINKLE_BENCHMARK == 1) {
+    Serial.begin(9600);
+    delay(3000);
+    BenchmarkTwinkles();
   }
-  
-  delay(3000);  // safety startup delay
-  PublishParticleAttributes();
 
-  FastLED.addLeds<LED_TYPE, DATA_PIN, COLOR_ORDER>(leds, NUM_LEDS)
-      .setCorrection(TypicalLEDStrip);
+  gControllers.addLeds<0>(leds, NUM_LEDS)
+      .setCorrection(TypicalLEDStrip)
+      .setPowerModel(&gStripPowerModel);
   FastLED.setBrightness(lightBrightness);
-  ChooseNextColorPalette(gTargetPalette);
+  gPowerGovernor.setMaxPowerInVoltsAndMilliamps(VOLTS, MAX_MA);
+  gPostProcess.setGovernor(&gPowerGovernor);
+  if (!restored) {
+    ChooseNextColorPalette(gTargetPalette);
+  }
 }
 
 void loop() {
+  ServiceCloud();
+  DrainCommands();
+
+  if (gMerryXmas && millis() - gMerryXmasStartMs >= MERRY_XMAS_MS) {
+    gMerryXmas = false;
+    cyclePatterns = true;
+    if (!gMerryXmasLightsWereOn) {
+      currentState = false;
+    }
+  }
+
   if (currentState != lightState) {
     lightState = currentState;
   }
@@ -69,29 +227,166 @@ void loop() {
   }
 
   if (lightState || shouldNotify) {
-    EVERY_N_SECONDS(SECONDS_PER_PALETTE) {
+    static CEveryNSeconds paletteTimer(SECONDS_PER_PALETTE);
+    paletteTimer.setPeriod(gTwinkle.secondsPerPalette);
+    if (paletteTimer) {
       ChooseNextColorPalette(gTargetPalette);
     }
     EVERY_N_MILLISECONDS(10) {
       if (shouldNotify) {
         BlinkRainbow();
       }
-      nblendPaletteTowardPalette(gCurrentPalette, gTargetPalette, 12);
+      if (!gMerryXmas && !gSceneFading) {
+        nblendPaletteTowardPalette(gCurrentPalette, gTargetPalette, 12);
+      }
+    }
+    if (gSceneFading) {
+      FadeScene();
     }
     DrawTwinkles();
-    FastLED.show();
+    gPostProcess.show(gControllers);
+    EVERY_N_SECONDS(1) {
+      gPowerCappedPercent = gPowerGovernor.getCappedPercent();
+    }
   }
 
   if (!lightState) {
     fill_solid(leds, NUM_LEDS, CRGB(0, 0, 0));
     FastLED.clear();
-    FastLED.show();
+    gControllers.show();
   }
+
+  if (gBootToFirstFrameMs < 0) {
+    gBootToFirstFrameMs = millis();
+  }
+
+  SaveSnapshot();
 }
 
-void TurnLightsOn() { ParticleTurnLightsOn(""); }
+// Bring the cloud connection up without ever waiting for it. The
+// system thread does the connecting (and reconnecting); this only
+// starts it, and registers the functions and variables the first time
+// the link is up.
+void ServiceCloud() {
+  switch (gCloudState) {
+    case kCloudOffline:
+      Particle.connect();
+      gCloudState = kCloudConnecting;
+      break;
+    case kCloudConnecting:
+      if (Particle.connected()) {
+        if (!gCloudPublished) {
+          PublishParticleAttributes();
+          gCloudPublished = true;
+        }
+        gCloudState = kCloudOnline;
+      }
+      break;
+    case kCloudOnline:
+      if (!Particle.connected()) {
+        gCloudState = kCloudConnecting;
+      }
+      break;
+  }
+}
 
-void TurnLightsOff() { ParticleTurnLightsOff(""); }
+// Apply every command the cloud handlers have queued since the last
+// frame.
+void DrainCommands() {
+  Command command;
+  while (gCommands.pop(command)) {
+    ApplyCommand(command);
+  }
+}
+
+void ApplyCommand(const Command &command) {
+  switch (command.op) {
+    case kCommandLightsOn:
+      currentState = true;
+      break;
+    case kCommandLightsOff:
+      currentState = false;
+      break;
+    case kCommandSetBrightness:
+      lightBrightness = command.value;
+      FastLED.setBrightness(lightBrightness);
+      break;
+    case kCommandNotify:
+      shouldNotify = true;
+      break;
+    case kCommandNextPattern:
+      ChooseNextColorPalette(gTargetPalette);
+      break;
+    case kCommandMerryXmas:
+      // Red, green and white for MERRY_XMAS_MS without blending or
+      // cycling away, then back to how things were; loop() ends it.
+      if (!gMerryXmas) {
+        gMerryXmasLightsWereOn = currentState;
+        gMerryXmasPalette = gCurrentPalette;
+      }
+      gMerryXmas = true;
+      gMerryXmasStartMs = millis();
+      currentState = true;
+      cyclePatterns = false;
+      gCurrentPalette = RedGreenWhite_p;
+      break;
+    case kCommandScene:
+      ApplyScene(command.scene);
+      break;
+    case kCommandTwinkle:
+      gTwinkle = command.twinkle;
+      SaveTwinkleParams();
+      break;
+  }
+}
+
+// Everything in the scene takes effect before the next frame is drawn,
+// except that the palette and brightness fade over scene.transitionMs
+// from what was showing (see FadeScene()). Going dark is immediate.
+void ApplyScene(const Scene &scene) {
+  gSceneFadeFromPalette = gCurrentPalette;
+  gSceneFadeFromBrightness = FastLED.getBrightness();
+  if (!lightState) {
+    // coming on: fade up from dark, straight into the new palette
+    gSceneFadeFromPalette = *(ActivePaletteList[scene.palette]);
+    gSceneFadeFromBrightness = 0;
+  }
+
+  currentState = scene.on;
+  lightBrightness = scene.brightness;
+  gPaletteIndex = scene.palette;
+  gTargetPalette = *(ActivePaletteList[gPaletteIndex]);
+  gTwinkle.speed = scene.twinkleSpeed;
+  gTwinkle.density = scene.twinkleDensity;
+  SaveTwinkleParams();
+
+  gSceneFading = true;
+  gSceneFadeStartMs = millis();
+  gSceneFadeMs = scene.on ? scene.transitionMs : 0;
+  FadeScene();
+}
+
+// One frame's step of a scene's fade.
+void FadeScene() {
+  uint32_t elapsed = millis() - gSceneFadeStartMs;
+  if (elapsed >= gSceneFadeMs) {
+    gCurrentPalette = gTargetPalette;
+    FastLED.setBrightness(lightBrightness);
+    gSceneFading = false;
+    return;
+  }
+  uint8_t amount = elapsed * 256 / gSceneFadeMs;
+  for (uint8_t i = 0; i < 16; i++) {
+    gCurrentPalette[i] =
+        blend(gSceneFadeFromPalette[i], gTargetPalette[i], amount);
+  }
+  FastLED.setBrightness(
+      lerp8by8(gSceneFadeFromBrightness, lightBrightness, amount));
+}
+
+void TurnLightsOn() { ApplyCommand({kCommandLightsOn, 0}); }
+
+void TurnLightsOff() { ApplyCommand({kCommandLightsOff, 0}); }
 
 void Rainbow() { fill_rainbow(leds, NUM_LEDS, 0, 7); }
 
@@ -100,40 +395,150 @@ void BlinkRainbow() {
   currentState = true;
   for (int i = 0; i < 5; i++) {
     FastLED.clear();
-    FastLED.show();
+    gControllers.show();
     delay(250);
     Rainbow();
-    FastLED.show();
+    gControllers.show();
     delay(250);
   }
   currentState = originalLightState;
   shouldNotify = false;
 }
 
+// MerryXMAS is left out: a restart in the middle of it comes back as
+// things were before it, and loop() would have ended it soon anyway.
+StateSnapshot CurrentSnapshot() {
+  StateSnapshot state;
+  state.on = gMerryXmas ? gMerryXmasLightsWereOn : currentState;
+  state.brightness = lightBrightness;
+  state.palette = gPaletteIndex;
+  return state;
+}
+
+// Keep both snapshots up to date: the one in backup RAM every pass, the
+// one in EEPROM once a change has settled.
+void SaveSnapshot() {
+  StateSnapshot state = CurrentSnapshot();
+  const CRGBPalette16 &palette =
+      gMerryXmas ? gMerryXmasPalette : gCurrentPalette;
+  SaveRetainedSnapshot(state, (const uint8_t *)palette.entries,
+                       sizeof(palette.entries));
+  gSnapshots.Update(state, millis());
+}
+
+// Put the lights back the way they were before the restart: from
+// backup RAM after a reset, palette blend and all, or else from EEPROM.
+// False if there's nothing (valid) to go back to.
+bool RestoreSnapshot() {
+  StateSnapshot saved;
+  bool haveSaved = gSnapshots.Load(saved);
+  StateSnapshot state;
+  CRGBPalette16 palette;
+  bool warm = LoadRetainedSnapshot(state, (uint8_t *)palette.entries,
+                                   sizeof(palette.entries));
+  if (!warm) {
+    if (!haveSaved) {
+      return false;
+    }
+    state = saved;
+  }
+  if (state.on > 1 || state.palette >= ARRAY_SIZE(ActivePaletteList)) {
+    return false;
+  }
+
+  currentState = state.on;
+  lightBrightness = state.brightness;
+  gPaletteIndex = state.palette;
+  gTargetPalette = *(ActivePaletteList[gPaletteIndex]);
+  gCurrentPalette = warm ? palette : gTargetPalette;
+  return true;
+}
+
+bool TwinkleParamsEqual(const TwinkleParams &a, const TwinkleParams &b) {
+  return a.speed == b.speed && a.density == b.density &&
+         a.secondsPerPalette == b.secondsPerPalette &&
+         a.coolLikeIncandescent == b.coolLikeIncandescent;
+}
+
+bool TwinkleParamsValid(const TwinkleParams &params) {
+  return params.speed <= 8 && params.density <= 8 &&
+         params.secondsPerPalette >= 1 && params.secondsPerPalette <= 3600 &&
+         params.coolLikeIncandescent <= 1;
+}
+
+struct StoredTwinkleParams {
+  uint16_t magic;
+  TwinkleParams params;
+};
+
+// Pick up the settings saved by SaveTwinkleParams(), if there are any.
+void LoadTwinkleParams() {
+  StoredTwinkleParams stored;
+  EEPROM.get(EEPROM_TWINKLE_ADDRESS, stored);
+  if (stored.magic == EEPROM_TWINKLE_MAGIC &&
+      TwinkleParamsValid(stored.params)) {
+    gTwinkle = stored.params;
+  }
+}
+
+// Save gTwinkle, if it isn't what's already saved.
+void SaveTwinkleParams() {
+  StoredTwinkleParams stored;
+  EEPROM.get(EEPROM_TWINKLE_ADDRESS, stored);
+  if (stored.magic == EEPROM_TWINKLE_MAGIC &&
+      TwinkleParamsEqual(stored.params, gTwinkle)) {
+    return;
+  }
+  memset(&stored, 0, sizeof(stored));
+  stored.magic = EEPROM_TWINKLE_MAGIC;
+  stored.params = gTwinkle;
+  EEPROM.put(EEPROM_TWINKLE_ADDRESS, stored);
+}
+
 void DrawTwinkles() {
-  uint16_t PRNG16 = 11337;
+  // Only the settings DrawTwinklesWith() reads count here; a different
+  // secondsPerPalette still draws with the constants.
+  if (gTwinkle.speed == kDefaultTwinkle.speed &&
+      gTwinkle.density == kDefaultTwinkle.density &&
+      gTwinkle.coolLikeIncandescent == kDefaultTwinkle.coolLikeIncandescent) {
+    DrawTwinklesWith<true>();
+  } else {
+    DrawTwinklesWith<false>();
+  }
+}
+
+// DEFAULTS: draw with the default twinkle settings as constants, rather
+// than reading gTwinkle.
+template <bool DEFAULTS>
+void DrawTwinklesWith() {
+  // Restart the same random stream every frame, so that each pixel
+  // gets the same clock offset, speed and salt on every pass.
+  CRandomStream rng(11337);
   uint32_t clock32 = millis();
 
   CRGB bg = CRGB::Black;
   uint8_t backgroundBrightness = bg.getAverageLight();
 
-  for (auto i = 0; i < NUM_LEDS; i++) {
-    CRGB &pixel = leds[i];
-    PRNG16 = (uint16_t)(PRNG16 * 2053) + 1384;  // next 'random' number
-    uint16_t myclockoffset16 = PRNG16;  // use that number as clock offset
-    PRNG16 = (uint16_t)(PRNG16 * 2053) + 1384;  // next 'random' number
-    // use that number as clock speed adjustment factor (in 8ths, from 8/8ths to
-    // 23/8ths)
-    uint8_t myspeedmultiplierQ5_3 =
-        ((((PRNG16 & 0xFF) >> 4) + (PRNG16 & 0x0F)) & 0x0F) + 0x08;
+  // Only the leds on the grid twinkle; the rest stay dark.
+  for (CLayoutPixel px : gLayout.offGridPixels()) {
+    leds[px.index] = CRGB::Black;
+  }
+
+  for (CLayoutPixel px : gLayout.onGridPixels()) {
+    CRGB &pixel = leds[px.index];
+    uint32_t r = rng.random32();  // 32 'random' bits for this pixel
+    uint16_t myclockoffset16 = r;  // use the low half as clock offset
+    // use 4 more bits as clock speed adjustment factor (in 8ths, from 8/8ths
+    // to 23/8ths)
+    uint8_t myspeedmultiplierQ5_3 = ((r >> 16) & 0x0F) + 0x08;
     uint32_t myclock30 =
         (uint32_t)((clock32 * myspeedmultiplierQ5_3) >> 3) + myclockoffset16;
-    uint8_t myunique8 = PRNG16 >> 8;  // get 'salt' value for this pixel
+    uint8_t myunique8 = r >> 24;  // get 'salt' value for this pixel
 
     // We now have the adjusted 'clock' for this pixel, now we call
     // the function that computes what color the pixel should be based
     // on the "brightness = f( time )" idea.
-    CRGB c = ComputeOneTwinkle(myclock30, myunique8);
+    CRGB c = ComputeOneTwinkle<DEFAULTS>(myclock30, myunique8);
     uint8_t cbright = c.getAverageLight();
     int16_t deltabright = cbright - backgroundBrightness;
     if (deltabright >= 32 || (!bg)) {
@@ -152,8 +557,14 @@ void DrawTwinkles() {
   }
 }
 
+template <bool DEFAULTS>
 CRGB ComputeOneTwinkle(uint32_t ms, uint8_t salt) {
-  uint16_t ticks = ms >> (8 - TWINKLE_SPEED);
+  const uint8_t speed = DEFAULTS ? TWINKLE_SPEED : gTwinkle.speed;
+  const uint8_t density = DEFAULTS ? TWINKLE_DENSITY : gTwinkle.density;
+  const bool cool = DEFAULTS ? (COOL_LIKE_INCANDESCENT == 1)
+                             : (gTwinkle.coolLikeIncandescent == 1);
+
+  uint16_t ticks = ms >> (8 - speed);
   uint8_t fastcycle8 = ticks;
   uint16_t slowcycle16 = (ticks >> 8) + salt;
   slowcycle16 += sin8(slowcycle16);
@@ -161,7 +572,7 @@ CRGB ComputeOneTwinkle(uint32_t ms, uint8_t salt) {
   uint8_t slowcycle8 = (slowcycle16 & 0xFF) + (slowcycle16 >> 8);
 
   uint8_t bright = 0;
-  if (((slowcycle8 & 0x0E) / 2) < TWINKLE_DENSITY) {
+  if (((slowcycle8 & 0x0E) / 2) < density) {
     bright = AttackDecayWave8(fastcycle8);
   }
 
@@ -169,7 +580,7 @@ CRGB ComputeOneTwinkle(uint32_t ms, uint8_t salt) {
   CRGB c;
   if (bright > 0) {
     c = ColorFromPalette(gCurrentPalette, hue, bright, NOBLEND);
-    if (COOL_LIKE_INCANDESCENT == 1) {
+    if (cool) {
       CoolLikeIncandescent(c, fastcycle8);
     }
   } else {
@@ -199,81 +610,150 @@ void ChooseNextColorPalette(CRGBPalette16 &pal) {
   if (cyclePatterns) {
     const uint8_t numberOfPalettes =
         sizeof(ActivePaletteList) / sizeof(ActivePaletteList[0]);
-    static uint8_t whichPalette = -1;
-    whichPalette = addmod8(whichPalette, 1, numberOfPalettes);
-    pal = *(ActivePaletteList[whichPalette]);
+    gPaletteIndex = addmod8(gPaletteIndex, 1, numberOfPalettes);
+    pal = *(ActivePaletteList[gPaletteIndex]);
   }
 }
 
 void PublishParticleAttributes() {
-  Particle.function("lightsOn", ParticleTurnLightsOn);
-  Particle.function("lightsOff", ParticleTurnLightsOff);
-  Particle.function("toggleLights", ParticleToggleLights);
-  Particle.function("brightness", ParticleSetBrightness);
-  Particle.function("notify", ParticleAlert);
-  Particle.function("nextPattern", ParticleNextPattern);
-  Particle.function("MerryXMAS", ParticleMerryXMAS);
+  for (CloudFunction &function : gCloudFunctions) {
+    Particle.function(function.name, &CloudFunction::Call, &function);
+  }
+  Particle.variable("powerCapped", gPowerCappedPercent);
+  Particle.variable("bootToFrameMs", gBootToFirstFrameMs);
 }
 
-int ParticleTurnLightsOn(String input) {
-  ParticleToggleLights("0=1");
-  return 0;
+int CloudFunction::Call(String args) {
+  CommandArgs parsed = {};
+  if (maxValues != ARGS_IGNORED) {
+    if (!ParseCommandArgs(args.c_str(), parsed) || parsed.count < minValues ||
+        parsed.count > maxValues) {
+      return CLOUD_BAD_ARGS;
+    }
+  }
+  return handler(parsed);
 }
 
-int ParticleTurnLightsOff(String input) {
-  ParticleToggleLights("0=0");
-  return 0;
+// The handlers only queue commands for loop(); see commands.h.
+int QueueCommand(CommandOp op, int32_t value) {
+  return gCommands.push({op, value}) ? 0 : CLOUD_QUEUE_FULL;
 }
 
-int ParticleSetBrightness(String brightness) {
-  lightBrightness = MAX_BRIGHTNESS * brightness.toInt() / 100;
-  FastLED.setBrightness(lightBrightness);
-  return lightBrightness;
-}
-
-int ParticleToggleLights(String args) {
-  int index = args.toInt();
-  int value;
-  char szArgs[MAX_ARGS];
-  args.toCharArray(szArgs, MAX_ARGS);
-  sscanf(szArgs, "%d=%d", &index, &value);
-  if (value == 1) {
-    currentState = true;
-    FastLED.show();
-  } else if (value == 0) {
-    currentState = false;
-    FastLED.clear();
-    FastLED.show();
+int CloudTurnLightsOn(const CommandArgs &args) {
+  return QueueCommand(kCommandLightsOn, 0);
+}
+
+int CloudTurnLightsOff(const CommandArgs &args) {
+  return QueueCommand(kCommandLightsOff, 0);
+}
+
+// "index=value": 1 turns the lights on and 0 off. The index is ignored.
+int CloudToggleLights(const CommandArgs &args) {
+  int result;
+  if (args.values[0] == 1) {
+    result = QueueCommand(kCommandLightsOn, 0);
+  } else if (args.values[0] == 0) {
+    result = QueueCommand(kCommandLightsOff, 0);
+  } else {
+    return CLOUD_BAD_ARGS;
+  }
+  return (result < 0) ? result : 1;
+}
+
+// A percentage, 0..100. Returns the brightness it comes to.
+int CloudSetBrightness(const CommandArgs &args) {
+  int32_t percent = args.values[0];
+  if (percent < 0 || percent > 100) {
+    return CLOUD_BAD_ARGS;
   }
-  return 1;
+  int value = MAX_BRIGHTNESS * percent / 100;
+  int result = QueueCommand(kCommandSetBrightness, value);
+  return (result < 0) ? result : value;
 }
 
-int ParticleAlert(String args) {
-  shouldNotify = true;
-  return 0;
+int CloudAlert(const CommandArgs &args) {
+  return QueueCommand(kCommandNotify, 0);
 }
 
-int ParticleNextPattern(String args) {
-  ChooseNextColorPalette(gTargetPalette);
-  return 0;
+int CloudNextPattern(const CommandArgs &args) {
+  return QueueCommand(kCommandNextPattern, 0);
 }
 
-int ParticleMerryXMAS(String args) {
-  bool lightsAlreadyOn = lightState;
-  if (!lightsAlreadyOn) {
-    TurnLightsOn();
+int CloudMerryXMAS(const CommandArgs &args) {
+  return QueueCommand(kCommandMerryXmas, 0);
+}
+
+// "on,brightness[,palette[,speed[,density[,transitionMs]]]]": on is 0
+// or 1, brightness a percentage as for "brightness", palette an index
+// into ActivePaletteList, speed and density 0..8 as TWINKLE_SPEED and
+// TWINKLE_DENSITY, and transitionMs up to MAX_TRANSITION_MS. Anything
+// left off stays as it is. Nothing changes unless all of it is valid.
+int CloudScene(const CommandArgs &args) {
+  // (read outside loop(), so at worst one command stale)
+  int32_t v[6] = {currentState, lightBrightness * 100 / MAX_BRIGHTNESS,
+                  gPaletteIndex, gTwinkle.speed, gTwinkle.density, 0};
+  for (uint8_t i = 0; i < args.count; i++) {
+    v[i] = args.values[i];
   }
-  cyclePatterns = false;
-  gCurrentPalette = RedGreenWhite_p;
-  for (int i = 0; i < 2000; i++) {
-    DrawTwinkles();
-    FastLED.show();
-    delay(10);
+  if (v[0] < 0 || v[0] > 1 || v[1] < 0 || v[1] > 100 || v[2] < 0 ||
+      v[2] >= (int32_t)ARRAY_SIZE(ActivePaletteList) || v[3] < 0 ||
+      v[3] > 8 || v[4] < 0 || v[4] > 8 || v[5] < 0 ||
+      v[5] > MAX_TRANSITION_MS) {
+    return CLOUD_BAD_ARGS;
+  }
+
+  Command command;
+  command.op = kCommandScene;
+  command.scene.on = v[0];
+  command.scene.brightness = MAX_BRIGHTNESS * v[1] / 100;
+  command.scene.palette = v[2];
+  command.scene.twinkleSpeed = v[3];
+  command.scene.twinkleDensity = v[4];
+  command.scene.transitionMs = v[5];
+  return gCommands.push(command) ? 0 : CLOUD_QUEUE_FULL;
+}
+
+// "speed[,density[,secondsPerPalette[,cool]]]", as TWINKLE_SPEED,
+// TWINKLE_DENSITY, SECONDS_PER_PALETTE and COOL_LIKE_INCANDESCENT.
+// Anything left off stays as it is. Kept in EEPROM.
+int CloudTwinkle(const CommandArgs &args) {
+  // (read outside loop(), so at worst one command stale)
+  int32_t v[4] = {gTwinkle.speed, gTwinkle.density,
+                  gTwinkle.secondsPerPalette, gTwinkle.coolLikeIncandescent};
+  for (uint8_t i = 0; i < args.count; i++) {
+    v[i] = args.values[i];
+  }
+  if (v[0] < 0 || v[0] > 8 || v[1] < 0 || v[1] > 8 || v[2] < 1 ||
+      v[2] > 3600 || v[3] < 0 || v[3] > 1) {
+    return CLOUD_BAD_ARGS;
   }
 
-  cyclePatterns = true;
-  if (!lightsAlreadyOn) {
-    TurnLightsOff();
+  Command command;
+  command.op = kCommandTwinkle;
+  command.twinkle.speed = v[0];
+  command.twinkle.density = v[1];
+  command.twinkle.secondsPerPalette = v[2];
+  command.twinkle.coolLikeIncandescent = v[3];
+  return gCommands.push(command) ? 0 : CLOUD_QUEUE_FULL;
+}
+
+// Time a frame of twinkles both ways DrawTwinkles() can draw it, with
+// the default settings, and print the best of a few runs of each.
+void BenchmarkTwinkles() {
+  bench8_init();
+  uint32_t best[2] = {UINT32_MAX, UINT32_MAX};
+  for (int run = 0; run < 8; run++) {
+    uint32_t start = bench8_cycles();
+    DrawTwinklesWith<true>();
+    uint32_t middle = bench8_cycles();
+    DrawTwinklesWith<false>();
+    uint32_t end = bench8_cycles();
+    if (middle - start < best[0]) best[0] = middle - start;
+    if (end - middle < best[1]) best[1] = end - middle;
   }
-  return 0;
+  char line[100];
+  snprintf(line, sizeof(line),
+           "twinkles, %d leds: %lu %s compile-time, %lu runtime\n", NUM_LEDS,
+           (unsigned long)best[0], bench8_units(), (unsigned long)best[1]);
+  Serial.print(line);
 }
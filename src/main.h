@@ -3,20 +3,41 @@ void ChooseNextColorPalette(CRGBPalette16 &pal);
 
 uint8_t AttackDecayWave8(uint8_t i);
 
+template <bool DEFAULTS>
 CRGB ComputeOneTwinkle(uint32_t ms, uint8_t salt);
 void CoolLikeIncandescent(CRGB &c, uint8_t phase);
+StateSnapshot CurrentSnapshot();
+void SaveSnapshot();
+bool RestoreSnapshot();
+
 void DrawTwinkles();
+template <bool DEFAULTS>
+void DrawTwinklesWith();
+bool TwinkleParamsEqual(const TwinkleParams &a, const TwinkleParams &b);
+bool TwinkleParamsValid(const TwinkleParams &params);
+void LoadTwinkleParams();
+void SaveTwinkleParams();
+void BenchmarkTwinkles();
 void BlinkRainbow();
 void Rainbow();
 
+void DrainCommands();
+void ApplyCommand(const Command &command);
+void ApplyScene(const Scene &scene);
+void FadeScene();
+
 void TurnLightsOn();
 void TurnLightsOff();
 
-int ParticleTurnLightsOn(String input);
-int ParticleTurnLightsOff(String input);
-int ParticleToggleLights(String input);
-int ParticleAlert(String input);
-int ParticleNextPattern(String input);
-int ParticleMerryXMAS(String input);
-int ParticleSetBrightness(String input);
+void ServiceCloud();
 void PublishParticleAttributes();
+int QueueCommand(CommandOp op, int32_t value);
+int CloudTurnLightsOn(const CommandArgs &args);
+int CloudTurnLightsOff(const CommandArgs &args);
+int CloudToggleLights(const CommandArgs &args);
+int CloudAlert(const CommandArgs &args);
+int CloudNextPattern(const CommandArgs &args);
+int CloudMerryXMAS(const CommandArgs &args);
+int CloudSetBrightness(const CommandArgs &args);
+int CloudScene(const CommandArgs &args);
+int CloudTwinkle(const CommandArgs &args);
@@ -0,0 +1,133 @@
+#include "Particle.h"
+#include <snapshot.h>
+
+static bool SameState(const StateSnapshot &a, const StateSnapshot &b) {
+  return a.on == b.on && a.brightness == b.brightness &&
+         a.palette == b.palette;
+}
+
+SnapshotStore::SnapshotStore(int address)
+    : address_(address),
+      nextSlot_(0),
+      sequence_(0),
+      haveStored_(false),
+      pendingSinceMs_(0) {
+  memset(&stored_, 0, sizeof(stored_));
+  memset(&pending_, 0, sizeof(pending_));
+}
+
+int SnapshotStore::Size() { return SNAPSHOT_SLOTS * sizeof(Record); }
+
+// Erased EEPROM (all 0xFF) and zeroed EEPROM both fail this.
+uint8_t SnapshotStore::Check(const Record &record) {
+  uint8_t sum = 0x5A;
+  sum += record.sequence;
+  sum += record.sequence >> 8;
+  sum += record.state.on;
+  sum += record.state.brightness;
+  sum += record.state.palette;
+  return ~sum;
+}
+
+bool SnapshotStore::Load(StateSnapshot &state) {
+  bool found = false;
+  uint8_t newestSlot = 0;
+  Record newest;
+  for (uint8_t slot = 0; slot < SNAPSHOT_SLOTS; slot++) {
+    Record record;
+    EEPROM.get(address_ + slot * sizeof(Record), record);
+    if (record.check != Check(record)) {
+      continue;
+    }
+    // sequence numbers wrap; the valid ones are never more than
+    // SNAPSHOT_SLOTS apart
+    if (!found || (int16_t)(record.sequence - newest.sequence) > 0) {
+      newest = record;
+      newestSlot = slot;
+      found = true;
+    }
+  }
+  if (!found) {
+    return false;
+  }
+
+  nextSlot_ = (newestSlot + 1) % SNAPSHOT_SLOTS;
+  sequence_ = newest.sequence + 1;
+  stored_ = newest.state;
+  haveStored_ = true;
+  pending_ = newest.state;
+  state = newest.state;
+  return true;
+}
+
+void SnapshotStore::Update(const StateSnapshot &state, uint32_t nowMs) {
+  if (!SameState(state, pending_)) {
+    pending_ = state;
+    pendingSinceMs_ = nowMs;
+    return;
+  }
+  if (haveStored_ && SameState(pending_, stored_)) {
+    return;
+  }
+  if (nowMs - pendingSinceMs_ >= SNAPSHOT_SETTLE_MS) {
+    Store(pending_);
+  }
+}
+
+void SnapshotStore::Store(const StateSnapshot &state) {
+  Record record;
+  memset(&record, 0, sizeof(record));
+  record.sequence = sequence_++;
+  record.state = state;
+  record.check = Check(record);
+  EEPROM.put(address_ + nextSlot_ * sizeof(Record), record);
+  nextSlot_ = (nextSlot_ + 1) % SNAPSHOT_SLOTS;
+  stored_ = state;
+  haveStored_ = true;
+}
+
+#define RETAINED_SNAPSHOT_MAGIC 0x534E4150  // "SNAP"
+#define RETAINED_PALETTE_BYTES 48
+
+struct RetainedSnapshot {
+  uint32_t magic;
+  StateSnapshot state;
+  uint8_t palette[RETAINED_PALETTE_BYTES];
+  uint8_t check;
+};
+
+retained static RetainedSnapshot gRetained;
+
+static uint8_t RetainedCheck(const RetainedSnapshot &snapshot) {
+  uint8_t sum = snapshot.state.on + snapshot.state.brightness +
+                snapshot.state.palette;
+  for (uint8_t i = 0; i < RETAINED_PALETTE_BYTES; i++) {
+    sum += snapshot.palette[i];
+  }
+  return ~sum;
+}
+
+void SaveRetainedSnapshot(const StateSnapshot &state,
+                          const uint8_t *palette, uint8_t paletteBytes) {
+  if (paletteBytes > RETAINED_PALETTE_BYTES) {
+    paletteBytes = RETAINED_PALETTE_BYTES;
+  }
+  gRetained.magic = RETAINED_SNAPSHOT_MAGIC;
+  gRetained.state = state;
+  memcpy(gRetained.palette, palette, paletteBytes);
+  gRetained.check = RetainedCheck(gRetained);
+}
+
+bool LoadRetainedSnapshot(StateSnapshot &state, uint8_t *palette,
+                          uint8_t paletteBytes) {
+  if (gRetained.magic != RETAINED_SNAPSHOT_MAGIC ||
+      gRetained.check != RetainedCheck(gRetained)) {
+    return false;
+  }
+  if (paletteBytes > RETAINED_PALETTE_BYTES) {
+    paletteBytes = RETAINED_PALETTE_BYTES;
+  }
+  state = gRetained.state;
+  memcpy(palette, gRetained.palette, paletteBytes);
+  return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+// What the lights need to come back as they were after a restart.
+struct StateSnapshot {
+  uint8_t on;          // 0 or 1
+  uint8_t brightness;  // 0..MAX_BRIGHTNESS
+  uint8_t palette;     // index into ActivePaletteList
+};
+
+// StateSnapshots kept in EEPROM across power cycles.
+//
+// Each save goes into the next of SNAPSHOT_SLOTS records in a ring,
+// stamped with a sequence number and a check byte, so the writes are
+// spread over all of them and a save cut short by a power failure
+// leaves the one before it to fall back on. Update() is called every
+// pass of loop() and saves only once a change has held for
+// SNAPSHOT_SETTLE_MS, so e.g. dragging a brightness slider costs one
+// write rather than dozens.
+#define SNAPSHOT_SLOTS 16
+#define SNAPSHOT_SETTLE_MS 5000
+
+class SnapshotStore {
+ public:
+  explicit SnapshotStore(int address);
+
+  // The newest valid record in the ring. False if there isn't one
+  // (e.g. the first boot), leaving 'state' alone.
+  bool Load(StateSnapshot &state);
+
+  // Save 'state' once it has held for SNAPSHOT_SETTLE_MS and differs
+  // from what was saved last.
+  void Update(const StateSnapshot &state, uint32_t nowMs);
+
+  // How many bytes of EEPROM the ring takes from 'address' on.
+  static int Size();
+
+ private:
+  struct Record {
+    uint16_t sequence;
+    StateSnapshot state;
+    uint8_t check;
+  };
+
+  static uint8_t Check(const Record &record);
+  void Store(const StateSnapshot &state);
+
+  int address_;
+  uint8_t nextSlot_;
+  uint16_t sequence_;
+  StateSnapshot stored_;   // what the newest record holds
+  bool haveStored_;
+  StateSnapshot pending_;  // what Update() saw last
+  uint32_t pendingSinceMs_;
+};
+
+// The same, plus the palette as it was mid-blend, kept in the backup
+// RAM that survives a reset (but not a power cycle), and saved every
+// frame since it doesn't wear. It lets a warm restart carry on from
+// exactly where it was. Needs FEATURE_RETAINED_MEMORY.
+void SaveRetainedSnapshot(const StateSnapshot &state,
+                          const uint8_t *palette, uint8_t paletteBytes);
+bool LoadRetainedSnapshot(StateSnapshot &state, uint8_t *palette,
+                          uint8_t paletteBytes);
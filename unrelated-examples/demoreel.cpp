@@ -224,10 +224,22 @@ void bpm() {
 
 void juggle() {
   // eight colored dots, weaving in and out of sync with each other
+  // one clock read per frame for all eight dots
+  static CBeatBank<8> dots;
+  static bool dotsReady = false;
+  if (!dotsReady) {
+    for (int i = 0; i < 8; i++) {
+      dots.set(i, i + 7, 0, NUM_LEDS);
+    }
+    dotsReady = true;
+  }
+  uint16_t pos[8];
+  dots.beatsin16_all(pos);
+
   fadeToBlackBy(leds, NUM_LEDS, 20);
   byte dothue = 0;
   for (int i = 0; i < 8; i++) {
-    leds[beatsin16(i + 7, 0, NUM_LEDS)] |= CHSV(dothue, 200, 255);
+    leds[pos[i]] |= CHSV(dothue, 200, 255);
     dothue += 32;
   }
 }